@@ -1,24 +1,236 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import i2c
-from esphome import pins
-from esphome.const import CONF_ID, CONF_PIN
+import esphome.final_validate as fv
+from esphome.components import i2c, sensor
+from esphome import automation, pins
+from esphome.const import (
+    CONF_I2C_ID,
+    CONF_ID,
+    CONF_PIN,
+    CONF_PLATFORM,
+    CONF_VARIANT,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_MILLISECOND,
+)
+from esphome.core import CORE
 
 MULTI_CONF = True
 DEPENDENCIES = ["i2c"]
-AUTO_LOAD = ["sensor"]
+AUTO_LOAD = ["sensor", "i2c_arbiter"]
 
 dallas_ns = cg.esphome_ns.namespace("dallas")
 DallasComponent = dallas_ns.class_("DallasComponent", cg.PollingComponent, i2c.I2CDevice)
 
-CONFIG_SCHEMA = cv.Schema(
-    {
-        cv.GenerateID(): cv.declare_id(DallasComponent),
-    }
-).extend(cv.polling_component_schema("60s")).extend(i2c.i2c_device_schema(0x18))
+DiagnosticSensor = dallas_ns.enum("DiagnosticSensor")
+DumpTraceAction = dallas_ns.class_("DumpTraceAction", automation.Action)
+
+CONF_TIMED_TRANSFERS = "timed_transfers"
+CONF_MAX_DEVICES = "max_devices"
+CONF_RESCAN = "rescan"
+CONF_ALARM_SEARCH = "alarm_search"
+CONF_CONTINUOUS = "continuous"
+CONF_PERSIST_DEVICES = "persist_devices"
+CONF_PROBE_INTERVAL = "probe_interval"
+CONF_CONVERSION_POLLING = "conversion_polling"
+CONF_TRACE_SIZE = "trace_size"
+CONF_WORKER_TASK = "worker_task"
+
+# Channels per chip variant
+VARIANTS = {
+    "DS2482-100": 1,
+    "DS2482-800": 8,
+}
+
+CONF_SWEEP_DURATION = "sweep_duration"
+CONF_BUS_THROUGHPUT = "bus_throughput"
+DIAGNOSTIC_COUNTERS = {
+    "i2c_transactions": DiagnosticSensor.DIAGNOSTIC_I2C_TRANSACTIONS,
+    "busy_polls": DiagnosticSensor.DIAGNOSTIC_BUSY_POLLS,
+    "busy_timeouts": DiagnosticSensor.DIAGNOSTIC_BUSY_TIMEOUTS,
+    "crc_errors": DiagnosticSensor.DIAGNOSTIC_CRC_ERRORS,
+    "presence_errors": DiagnosticSensor.DIAGNOSTIC_PRESENCE_ERRORS,
+    "short_circuits": DiagnosticSensor.DIAGNOSTIC_SHORT_CIRCUITS,
+}
+CONF_CHANNEL_ERRORS = [f"channel_{channel}_errors" for channel in range(8)]
+
+# Counts per update interval: the running totals would outgrow a float
+COUNTER_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+
+def validate_channel_errors(config):
+    channels = VARIANTS[config[CONF_VARIANT]]
+    for key in CONF_CHANNEL_ERRORS[channels:]:
+        if key in config:
+            raise cv.Invalid(f"{config[CONF_VARIANT]} has no channel for {key}")
+    return config
+
+
+def validate_worker_task(config):
+    if config[CONF_WORKER_TASK] and not (CORE.is_esp32 or CORE.is_host):
+        raise cv.Invalid(f"{CONF_WORKER_TASK} is only available on ESP32 and host builds")
+    return config
+
+
+# Components that take the I2C bus arbiter lock for every transfer
+ARBITER_CLIENTS = {"dallas_ds2482", "tca6408a"}
+
+
+def _i2c_devices(domain, value):
+    """Component name and bus id of every I2C device in a config subtree."""
+    if isinstance(value, list):
+        for item in value:
+            yield from _i2c_devices(domain, item)
+    elif isinstance(value, dict):
+        if CONF_I2C_ID in value:
+            yield value.get(CONF_PLATFORM, domain), str(value[CONF_I2C_ID])
+        for item in value.values():
+            yield from _i2c_devices(domain, item)
+
+
+def final_validate_worker_task(config):
+    # The worker is built for all hubs or none, so every hub's bus counts
+    full_config = fv.full_config.get()
+    if not any(conf[CONF_WORKER_TASK] for conf in full_config["dallas_ds2482"]):
+        return
+    bus = str(config[CONF_I2C_ID])
+    for domain, value in full_config.items():
+        for name, bus_id in _i2c_devices(domain, value):
+            if bus_id == bus and name not in ARBITER_CLIENTS:
+                raise cv.Invalid(
+                    f"{CONF_WORKER_TASK} drives I2C bus {bus} from its own task, "
+                    f"{name} on the same bus does not take the bus lock"
+                )
+
+
+# Flash preferences of an ESP8266 share 512 bytes, a record of 8 devices takes 100
+ESP8266_MAX_PERSISTED_DEVICES = 24
+
+
+def validate_persist_devices(config):
+    if (
+        config[CONF_PERSIST_DEVICES]
+        and CORE.is_esp8266
+        and config[CONF_MAX_DEVICES] > ESP8266_MAX_PERSISTED_DEVICES
+    ):
+        raise cv.Invalid(
+            f"{CONF_PERSIST_DEVICES} on ESP8266 needs {CONF_MAX_DEVICES} of "
+            f"{ESP8266_MAX_PERSISTED_DEVICES} or less"
+        )
+    return config
+
+
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(DallasComponent),
+            cv.Optional(CONF_VARIANT, default="DS2482-800"): cv.one_of(*VARIANTS, upper=True),
+            cv.Optional(CONF_TIMED_TRANSFERS, default=False): cv.boolean,
+            cv.Optional(CONF_MAX_DEVICES, default=64): cv.int_range(min=1, max=255),
+            cv.Optional(CONF_RESCAN, default=False): cv.boolean,
+            # Read sensors with alarm thresholds only while an ALARM SEARCH finds them,
+            # and on every 10th sweep otherwise; they publish when read
+            cv.Optional(CONF_ALARM_SEARCH, default=False): cv.boolean,
+            # Convert back to back and publish the latest reading on each update,
+            # at the cost of a busy bus and a little self heating
+            cv.Optional(CONF_CONTINUOUS, default=False): cv.boolean,
+            cv.Optional(CONF_PERSIST_DEVICES, default=False): cv.boolean,
+            # Check channels without devices for new ones, 0s never does
+            cv.Optional(
+                CONF_PROBE_INTERVAL, default="10min"
+            ): cv.positive_time_period_milliseconds,
+            # Read slot cadence while waiting for a conversion, 0ms waits the worst case
+            cv.Optional(CONF_CONVERSION_POLLING, default="0ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=750)),
+            ),
+            # Events kept by the binary bus trace, 0 compiles the trace out
+            cv.Optional(CONF_TRACE_SIZE, default=0): cv.int_range(min=0, max=4096),
+            # Run the bus work in a task of its own, off the main loop
+            cv.Optional(CONF_WORKER_TASK, default=False): cv.boolean,
+            cv.Optional(CONF_SWEEP_DURATION): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_BUS_THROUGHPUT): sensor.sensor_schema(
+                unit_of_measurement="sensors/s",
+                accuracy_decimals=1,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            **{cv.Optional(key): COUNTER_SCHEMA for key in DIAGNOSTIC_COUNTERS},
+            **{cv.Optional(key): COUNTER_SCHEMA for key in CONF_CHANNEL_ERRORS},
+        }
+    )
+    .extend(cv.polling_component_schema("60s"))
+    .extend(i2c.i2c_device_schema(0x18)),
+    validate_channel_errors,
+    validate_worker_task,
+    validate_persist_devices,
+)
+
+FINAL_VALIDATE_SCHEMA = final_validate_worker_task
 
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await i2c.register_i2c_device(var, config)
+
+    cg.add(var.setChannelCount(VARIANTS[config[CONF_VARIANT]]))
+    cg.add(var.setTimedMode(config[CONF_TIMED_TRANSFERS]))
+    cg.add(var.set_rescan(config[CONF_RESCAN]))
+    cg.add(var.set_alarm_search(config[CONF_ALARM_SEARCH]))
+    cg.add(var.set_continuous(config[CONF_CONTINUOUS]))
+    cg.add(var.set_persist_devices(config[CONF_PERSIST_DEVICES]))
+    if config[CONF_PERSIST_DEVICES]:
+        cg.add(var.set_persist_key(config[CONF_ID].id))
+    cg.add(var.set_probe_interval(config[CONF_PROBE_INTERVAL]))
+    cg.add(var.set_conversion_poll_interval(config[CONF_CONVERSION_POLLING]))
+
+    if CONF_SWEEP_DURATION in config:
+        sens = await sensor.new_sensor(config[CONF_SWEEP_DURATION])
+        cg.add(var.set_diagnostic_sensor(DiagnosticSensor.DIAGNOSTIC_SWEEP_DURATION, sens))
+    if CONF_BUS_THROUGHPUT in config:
+        sens = await sensor.new_sensor(config[CONF_BUS_THROUGHPUT])
+        cg.add(var.set_diagnostic_sensor(DiagnosticSensor.DIAGNOSTIC_BUS_THROUGHPUT, sens))
+    for key, counter in DIAGNOSTIC_COUNTERS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(var.set_diagnostic_sensor(counter, sens))
+    for channel, key in enumerate(CONF_CHANNEL_ERRORS):
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(var.set_channel_error_sensor(channel, sens))
+
+    # The device table is sized at compile time, so all hubs share the largest size
+    max_devices = max(conf[CONF_MAX_DEVICES] for conf in CORE.config["dallas_ds2482"])
+    cg.add_define("DALLAS_DS2482_MAX_DEVICES", max_devices)
+    # Channel selection compiles out when every hub is a DS2482-100
+    channels = max(VARIANTS[conf[CONF_VARIANT]] for conf in CORE.config["dallas_ds2482"])
+    cg.add_define("DALLAS_DS2482_CHANNELS", channels)
+    # Trace points cost nothing unless a hub asks for the trace
+    trace_size = max(conf[CONF_TRACE_SIZE] for conf in CORE.config["dallas_ds2482"])
+    if trace_size > 0:
+        cg.add_define("DALLAS_DS2482_TRACE", trace_size)
+    # The worker owns the bus group, so it is all hubs or none
+    if any(conf[CONF_WORKER_TASK] for conf in CORE.config["dallas_ds2482"]):
+        cg.add_define("DALLAS_DS2482_WORKER")
+
+
+@automation.register_action(
+    "dallas_ds2482.dump_trace",
+    DumpTraceAction,
+    automation.maybe_simple_id({cv.GenerateID(): cv.use_id(DallasComponent)}),
+)
+async def dump_trace_to_code(config, action_id, template_arg, args):
+    # Logs a note instead when no hub set trace_size
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
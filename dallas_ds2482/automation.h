@@ -0,0 +1,15 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "dallas_component.h"
+
+namespace esphome {
+namespace dallas {
+
+template<typename... Ts> class DumpTraceAction : public Action<Ts...>, public Parented<DallasComponent> {
+ public:
+  void play(Ts... x) override { this->parent_->dump_trace(); }
+};
+
+}  // namespace dallas
+}  // namespace esphome
@@ -1,6 +1,15 @@
 #include "dallas_component.h"
 #include "esphome/core/log.h"
 
+#ifdef DALLAS_DS2482_WORKER
+#ifdef USE_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+#endif
+
 namespace esphome {
 namespace dallas {
 
@@ -14,6 +23,42 @@ static const uint8_t DALLAS_MODEL_DS28EA00 = 0x42;
 static const uint8_t DALLAS_COMMAND_START_CONVERSION = 0x44;
 static const uint8_t DALLAS_COMMAND_READ_SCRATCH_PAD = 0xBE;
 static const uint8_t DALLAS_COMMAND_WRITE_SCRATCH_PAD = 0x4E;
+static const uint8_t DALLAS_COMMAND_COPY_SCRATCH_PAD = 0x48;
+static const uint8_t DALLAS_COMMAND_READ_POWER_SUPPLY = 0xB4;
+/// Worst case EEPROM write time (tWR) of COPY SCRATCHPAD.
+static const uint8_t DALLAS_EEPROM_WRITE_MS = 10;
+/// Read slots during an EEPROM write, a few per write at most.
+static const uint8_t DALLAS_EEPROM_POLL_MS = 2;
+
+/// Families the targeted searches enumerate, everything else on the bus is skipped.
+static const uint8_t DALLAS_TEMPERATURE_FAMILIES[] = {DALLAS_MODEL_DS18S20, DALLAS_MODEL_DS1822, DALLAS_MODEL_DS18B20,
+                                                      DALLAS_MODEL_DS1825, DALLAS_MODEL_DS28EA00};
+static const uint8_t DALLAS_TEMPERATURE_FAMILY_COUNT = sizeof(DALLAS_TEMPERATURE_FAMILIES);
+
+/// Main loop time one DallasBusGroup::loop() may spend on the bus.
+static const uint32_t DALLAS_GROUP_SLICE_US = 1000;
+/// Window over which the bus throughput is averaged.
+static const uint32_t DALLAS_THROUGHPUT_WINDOW_MS = 10000;
+/// With alarm_search, a sensor not in alarm is still read on every this many sweeps.
+static const uint8_t DALLAS_ALARM_FULL_READ = 10;
+
+#ifdef DALLAS_DS2482_WORKER
+static const uint32_t DALLAS_WORKER_STACK_SIZE = 4096;
+/// Same as the main loop task, the two take turns between loop() slices.
+static const uint8_t DALLAS_WORKER_PRIORITY = 1;
+/// Worker sleep when no hub has anything to do on the bus.
+static const uint32_t DALLAS_WORKER_IDLE_MS = 1;
+/// Longest the worker stays ready to run, lower priority tasks like idle get a turn after.
+static const uint32_t DALLAS_WORKER_BUSY_MS = 10;
+
+enum WarningRequest : uint8_t {
+  WARNING_UNCHANGED,
+  WARNING_SET,
+  WARNING_CLEAR,
+};
+#endif
+
+static std::vector<DallasBusGroup *> bus_groups;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 
 uint16_t DallasTemperatureSensor::millis_to_wait_for_conversion() const {
   switch (this->resolution_) {
@@ -28,73 +73,679 @@ uint16_t DallasTemperatureSensor::millis_to_wait_for_conversion() const {
   }
 }
 
-void DallasComponent::setup() {
-  ESP_LOGCONFIG(TAG, "Setting up DallasComponent...");
+void DurationHistogram::add(uint32_t us) {
+  uint8_t bucket = 0;
+  while (bucket < BUCKETS - 1 && (us >> (bucket + 1)))
+    bucket++;
+  if (this->counts[bucket] < UINT16_MAX) {
+    this->counts[bucket]++;
+    this->total++;
+  }
+  this->max = std::max(this->max, us);
+}
 
-  // clear bus with 480µs high, otherwise initial reset in search_vec() fails
-  delayMicroseconds(480); // required? probably no
- 
- for (int8_t channel = 0; channel < 8; channel++){
+uint32_t DurationHistogram::percentile(uint8_t percent) const {
+  uint32_t rank = (uint32_t(this->total) * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t bucket = 0; bucket < BUCKETS; bucket++) {
+    seen += this->counts[bucket];
+    if (seen >= rank && seen > 0)
+      return std::min(this->max, (uint32_t(2) << bucket) - 1);
+  }
+  return this->max;
+}
 
-      this->setChannel(channel);
-      this->wireResetSearch();
-        ESP_LOGI(TAG, "Channel: %d", channel);
+void DurationHistogram::clear() {
+  memset(this->counts, 0, sizeof(this->counts));
+  this->total = 0;
+  this->max = 0;
+}
 
-  std::vector<uint64_t> raw_sensors;
-  raw_sensors = this->search_vec();
+DallasBusGroup *DallasBusGroup::join(i2c::I2CBus *bus, DallasComponent *hub) {
+  for (auto *group : bus_groups) {
+    if (group->bus_ == bus) {
+      group->hubs_.push_back(hub);
+      return group;
+    }
+  }
+  auto *group = new DallasBusGroup();  // NOLINT(cppcoreguidelines-owning-memory)
+  group->bus_ = bus;
+  group->hubs_.push_back(hub);
+  group->window_start_ = millis();
+  bus_groups.push_back(group);
+  return group;
+}
 
-  for (auto &address : raw_sensors) {
+bool DallasBusGroup::loop() {
+  uint32_t start = micros();
+  uint8_t count = this->hubs_.size();
+  // Hubs that took part, they account the whole slice as their loop blocking
+  uint8_t active = 0;
+  bool busy;
 
-    auto *address8 = reinterpret_cast<uint8_t *>(&address);
-    if (crc8(address8, 7) != address8[7]) {
-      ESP_LOGW(TAG, "Dallas device 0x%s has invalid CRC.", format_hex(address).c_str());
-      continue;
+  do {
+    busy = false;
+    // Conversions first, they run in parallel with everything after them
+    for (uint8_t pass = 0; pass < 2; pass++) {
+      for (uint8_t n = 0; n < count; n++) {
+        uint8_t i = (this->next_ + n) % count;
+        auto *hub = this->hubs_[i];
+        if ((hub->sweep_state_ == SweepState::CONVERT) != (pass == 0))
+          continue;
+        if (hub->step_()) {
+          busy = true;
+          active |= 1 << i;
+        }
+      }
     }
-    if (address8[0] != DALLAS_MODEL_DS18S20 && address8[0] != DALLAS_MODEL_DS1822 &&
-        address8[0] != DALLAS_MODEL_DS18B20 && address8[0] != DALLAS_MODEL_DS1825 &&
-        address8[0] != DALLAS_MODEL_DS28EA00) {
-      ESP_LOGW(TAG, "Unknown device type 0x%02X.", address8[0]);
+  } while (busy && micros() - start < DALLAS_GROUP_SLICE_US);
+  this->next_ = (this->next_ + 1) % count;
+
+  uint32_t elapsed = micros() - start;
+  for (uint8_t i = 0; i < count; i++) {
+    if (active & (1 << i))
+      this->hubs_[i]->slice_time_.add(elapsed);
+  }
+  return active != 0;
+}
+
+#ifdef DALLAS_DS2482_WORKER
+void DallasBusGroup::start_worker() {
+  this->worker_running_ = true;
+#ifdef USE_ESP32
+  xTaskCreate(DallasBusGroup::worker_task_, "dallas_ds2482", DALLAS_WORKER_STACK_SIZE, this, DALLAS_WORKER_PRIORITY,
+              nullptr);
+#else
+  std::thread(DallasBusGroup::worker_task_, this).detach();
+#endif
+}
+
+void DallasBusGroup::worker_task_(void *arg) {
+  auto *group = static_cast<DallasBusGroup *>(arg);
+  uint32_t busy_since = millis();
+  while (true) {
+    if (group->loop() && millis() - busy_since < DALLAS_WORKER_BUSY_MS) {
+      // Let the main loop task have its turn between slices
+      yield();
       continue;
     }
-    address_channel entry;
-    entry.address = address;
-    entry.channel = channel; 
+    delay(DALLAS_WORKER_IDLE_MS);
+    busy_since = millis();
+  }
+}
+
+void DallasBusGroup::publish(sensor::Sensor *sensor, float value) {
+  if (!this->ring_.push({sensor, value}))
+    this->dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DallasBusGroup::drain() {
+  HandOff item;
+  while (this->ring_.pop(item))
+    item.sensor->publish_state(item.value);
+}
+#endif
+
+float DallasBusGroup::throughput() {
+  uint32_t elapsed = millis() - this->window_start_;
+  if (elapsed >= DALLAS_THROUGHPUT_WINDOW_MS) {
+    this->last_rate_ = this->reads_ * 1000.0f / elapsed;
+    this->reads_ = 0;
+    this->window_start_ += elapsed;
+  }
+  return this->last_rate_;
+}
+
+void DallasComponent::setup() {
+  ESP_LOGCONFIG(TAG, "Setting up DallasComponent...");
+  this->group_ = DallasBusGroup::join(this->bus_, this);
+  this->attachArbiter();
+  uint32_t setup_start = millis();
+  ds2482_bus_stats setup_bus = this->getBusStats();
+
+  // clear bus with 480µs high, otherwise initial reset in wireSearch() fails
+  delayMicroseconds(480); // required? probably no
+
+  bool cached = false;
+  if (this->persist_devices_)
+    cached = this->load_devices_();
+  if (!cached)
+    this->search_channels_();
 
-    this->found_sensors_channel_.push_back(entry);
+  // Same order as a full search, index sensors depend on it
+  this->devices_.sort();
+  if (cached && !this->restore_configured_()) {
+    ESP_LOGW(TAG, "Cached devices don't cover all sensors, searching all channels");
+    this->unverified_ = 0;
+    this->search_channels_();
+    this->devices_.sort();
+    for (auto *sensor : this->sensors_)
+      sensor->configured_ = false;
   }
- } 
 
   for (auto *sensor : this->sensors_) {
-            ESP_LOGD(TAG, "*");
-    if (sensor->get_index().has_value()) {
-                  ESP_LOGD(TAG, "#");
-      if (*sensor->get_index() >= this->found_sensors_channel_.size()) {
+    if (!this->bind_index_sensor_(sensor))
+      this->status_set_error();
+    if (sensor->get_channel() >= this->getChannelCount()) {
+      // Never read, build_read_order_() only covers the existing channels
+      ESP_LOGE(TAG, "'%s' - channel %u does not exist on this hub", sensor->get_name().c_str(), sensor->get_channel());
+      this->status_set_error();
+    }
+  }
 
-        this->status_set_error();
-        continue;
+  this->build_read_order_();
+  for (uint8_t channel = 0; channel < this->getChannelCount(); channel++) {
+    if (!this->configure_channel_(channel))
+      this->status_set_error();
+  }
+  if (this->persist_devices_ && this->table_dirty_)
+    this->save_devices_();
+  for (auto *sensor : this->sensors_) {
+    if (sensor->get_update_interval() != 0) {
+      sensor->next_due_ = millis();
+      this->interval_sensors_ = true;
+    }
+  }
+  this->next_interval_due_ = millis();
+#ifdef DALLAS_DS2482_WORKER
+  // The worker starts with the first loop(), until then the main loop owns the state
+  this->fill_view_(this->view_copy_);
+  this->show_view_(this->view_copy_);
+#endif
+
+  const ds2482_bus_stats &bus = this->getBusStats();
+  ESP_LOGCONFIG(TAG, "Search and sensor setup took %" PRIu32 " ms, %" PRIu32 " I2C transfers, %" PRIu32
+                     " bytes, %" PRIu32 " us busy waiting",
+                millis() - setup_start, bus.writes + bus.reads - setup_bus.writes - setup_bus.reads,
+                bus.bytes - setup_bus.bytes, bus.busyWaitUs - setup_bus.busyWaitUs);
+}
+
+void DallasComponent::search_channels_() {
+  this->devices_.clear();
+  for (uint8_t channel = 0; channel < this->getChannelCount(); channel++) {
+    this->setChannel(channel);
+    ESP_LOGI(TAG, "Channel: %d", channel);
+
+    uint64_t address;
+    for (uint8_t family : DALLAS_TEMPERATURE_FAMILIES) {
+      this->wireTargetSearch(family);
+      while (this->wireSearch(&address)) {
+        ESP_LOGI(TAG, "New Sensor: 0x%s", format_hex(address).c_str());
+
+        if (!this->valid_address_(address))
+          continue;
+        if (this->devices_.add(address, channel) < 0) {
+          ESP_LOGW(TAG, "Device table full (%u devices), ignoring 0x%s.", this->devices_.capacity(),
+                   format_hex(address).c_str());
+          break;
+        }
       }
+    }
+    this->detect_power_supply_(channel);
+  }
+  this->table_dirty_ = true;
+}
+
+void DallasComponent::set_persist_key(const std::string &key) { this->persist_key_ = fnv1_hash("dallas_ds2482_" + key); }
+
+ESPPreferenceObject &DallasComponent::record_pref_(uint16_t n) {
+  // Created as needed: an ESP8266 reserves the flash of a preference when it is made
+  while (this->prefs_.size() <= n) {
+    uint32_t base = this->persist_key_ != 0 ? this->persist_key_ : fnv1_hash("dallas_ds2482");
+    uint32_t key = base ^ (uint32_t(this->address_) << 8 | this->prefs_.size());
+    this->prefs_.push_back(global_preferences->make_preference<DeviceRecord>(key, true));
+  }
+  return this->prefs_[n];
+}
+
+bool DallasComponent::load_devices_() {
+  DeviceRecord record;
+  uint16_t count = 0;
+  for (uint16_t n = 0; n < DeviceTable::records(count); n++) {
+    if (!this->record_pref_(n).load(&record) || (n != 0 && record.count != count) ||
+        !this->devices_.load_record(n, record)) {
+      this->devices_.clear();
+      return false;
+    }
+    count = record.count;
+  }
+
+  this->parasite_channels_ = 0;
+  for (uint16_t i = 0; i < this->devices_.count; i++) {
+    this->devices_.state[i] = (this->devices_.state[i] & DEVICE_STATE_PARASITE) | DEVICE_STATE_PRESENT;
+    if (this->devices_.state[i] & DEVICE_STATE_PARASITE)
+      this->parasite_channels_ |= 1 << this->devices_.channel[i];
+  }
+  ESP_LOGCONFIG(TAG, "Using %u cached devices, the first reads verify them", this->devices_.count);
+  return true;
+}
+
+void DallasComponent::save_devices_() {
+#ifdef DALLAS_DS2482_WORKER
+  // Flash belongs to the main loop, it saves a copy. One save at a time, the
+  // table stays dirty and the next sweep tries again.
+  if (this->save_pending_.load(std::memory_order_acquire))
+    return;
+  this->save_copy_ = this->devices_;
+  this->save_pending_.store(true, std::memory_order_release);
+  this->table_dirty_ = false;
+#else
+  this->store_devices_(this->devices_);
+  this->table_dirty_ = false;
+#endif
+}
+
+#ifdef DALLAS_DS2482_WORKER
+void DallasComponent::apply_worker_requests_() {
+  switch (this->warning_request_.exchange(WARNING_UNCHANGED)) {
+    case WARNING_SET:
+      this->status_set_warning();
+      break;
+    case WARNING_CLEAR:
+      this->status_clear_warning();
+      break;
+    default:
+      break;
+  }
+  if (this->view_pending_.load(std::memory_order_acquire)) {
+    this->show_view_(this->view_copy_);
+    this->view_pending_.store(false, std::memory_order_release);
+  }
+  if (!this->save_pending_.load(std::memory_order_acquire))
+    return;
+  this->store_devices_(this->save_copy_);
+  this->save_pending_.store(false, std::memory_order_release);
+}
+
+void DallasComponent::publish_view_() {
+  // The main loop still holds the last one, the next sweep hands over a newer view
+  if (this->view_pending_.load(std::memory_order_acquire))
+    return;
+  this->fill_view_(this->view_copy_);
+  this->view_pending_.store(true, std::memory_order_release);
+}
 
-      sensor->set_address(this->found_sensors_channel_[*sensor->get_index()].address);
-      sensor->set_channel(this->found_sensors_channel_[*sensor->get_index()].channel);
+void DallasComponent::show_view_(const HubView &view) {
+  this->view_ = view;
+  for (size_t i = 0; i < this->sensors_.size(); i++) {
+    this->sensors_[i]->view_address_ = view.sensor_address[i];
+    this->sensors_[i]->view_channel_ = view.sensor_channel[i];
+  }
+}
+#endif
+
+void DallasComponent::fill_view_(HubView &view) const {
+  view.devices = this->devices_;
+  view.active_channels = this->active_channels_;
+  view.parasite_channels = this->parasite_channels_;
+  view.channel_selects_saved = this->getChannelSelectsSaved();
+  view.resumes_used = this->getResumesUsed();
+  view.sensor_address.resize(this->sensors_.size());
+  view.sensor_channel.resize(this->sensors_.size());
+  for (size_t i = 0; i < this->sensors_.size(); i++) {
+    view.sensor_address[i] = this->sensors_[i]->address_;
+    view.sensor_channel[i] = this->sensors_[i]->channel_;
+  }
+}
+
+void DallasComponent::store_devices_(const DeviceTable &table) {
+  DeviceRecord record;
+  uint16_t records = DeviceTable::records(table.count);
+  for (uint16_t n = 0; n < records; n++) {
+    table.store_record(n, record);
+    if (!this->record_pref_(n).save(&record)) {
+      ESP_LOGW(TAG, "Saving the device table failed, %u devices need %u bytes of flash", table.count,
+               unsigned(records * sizeof(DeviceRecord)));
+      return;
     }
+  }
+  ESP_LOGD(TAG, "Saved %u devices to flash", table.count);
+}
+
+bool DallasComponent::restore_configured_() {
+  this->unverified_ = 0;
+  for (auto *sensor : this->sensors_) {
+    if (sensor->get_index().has_value() && *sensor->get_index() >= this->devices_.count)
+      return false;
+    uint64_t address =
+        sensor->get_index().has_value() ? this->devices_.address[*sensor->get_index()] : sensor->get_address();
+    int16_t index = this->devices_.find(address);
+    if (index < 0)
+      return false;
+    sensor->configured_ = this->devices_.config_tag[index] == sensor->config_tag_();
+    // Only devices with a sensor get read, and so verified
+    if (!(this->devices_.state[index] & DEVICE_STATE_CACHED)) {
+      this->devices_.state[index] |= DEVICE_STATE_CACHED;
+      this->unverified_++;
+    }
+  }
+  return true;
+}
+
+void DallasComponent::verify_cached_(DallasTemperatureSensor *sensor, bool success) {
+  int16_t index = this->devices_.find(sensor->get_address());
+  if (index < 0 || !(this->devices_.state[index] & DEVICE_STATE_CACHED))
+    return;
+
+  if (!success) {
+    ESP_LOGW(TAG, "Cached device 0x%s does not answer, scanning all channels",
+             format_hex(sensor->get_address()).c_str());
+    this->cache_stale_ = true;
+    return;
+  }
+  this->devices_.state[index] &= ~DEVICE_STATE_CACHED;
+  this->unverified_--;
+  // The scratch pad just read shows whether the cached config still holds
+  if (!sensor->config_matches_()) {
+    sensor->configured_ = false;
+    this->reconfigure_channels_ |= 1 << sensor->get_channel();
+  }
+}
+
+void DallasComponent::start_refresh_() {
+  this->cache_stale_ = false;
+  this->unverified_ = 0;
+  for (uint16_t i = 0; i < this->devices_.count; i++)
+    this->devices_.state[i] &= ~DEVICE_STATE_CACHED;
+  // A device may have moved to any channel, the empty ones included
+  this->refresh_channels_ = (1 << this->getChannelCount()) - 1;
+  this->start_scan_(0);
+}
+
+void DallasComponent::detect_power_supply_(uint8_t channel) {
+  this->parasite_channels_ &= ~(1 << channel);
+  if (!this->channel_populated_(channel))
+    return;
+
+  this->setChannel(channel);
+  if (!this->wireReset())
+    return;
+  this->wireWriteByte(WIRE_COMMAND_SKIP);
+  this->wireWriteByte(DALLAS_COMMAND_READ_POWER_SUPPLY);
+  // Parasite powered devices pull the read slot low
+  if (!this->wireReadBit())
+    this->set_parasite_(channel);
+}
+
+void DallasComponent::start_power_check_() {
+  this->sweep_state_ = SweepState::POWER;
+  this->power_channel_ = this->next_channel_(this->power_channels_, this->getChannelCount() - 1);
+  this->power_channels_ &= ~(1 << this->power_channel_);
+  this->parasite_channels_ &= ~(1 << this->power_channel_);
+}
 
+void DallasComponent::power_result_(bool success) {
+  // Parasite powered devices pull the read slot low
+  if (success && !this->power_bit_)
+    this->set_parasite_(this->power_channel_);
+  this->end_sweep_();
+}
+
+void DallasComponent::set_parasite_(uint8_t channel) {
+  for (uint16_t i = 0; i < this->devices_.count; i++) {
+    if (this->devices_.channel[i] == channel)
+      this->devices_.state[i] |= DEVICE_STATE_PARASITE;
+  }
+  this->parasite_channels_ |= 1 << channel;
+  ESP_LOGI(TAG, "Channel %u: parasite powered devices, converting on the strong pullup", channel);
+}
+
+bool DallasComponent::channel_populated_(uint8_t channel) const {
+  for (uint16_t i = 0; i < this->devices_.count; i++) {
+    if (this->devices_.channel[i] == channel)
+      return true;
+  }
+  return false;
+}
+
+bool DallasComponent::valid_address_(uint64_t address) {
+  auto *address8 = reinterpret_cast<uint8_t *>(&address);
+  if (crc8(address8, 7) != address8[7]) {
+    ESP_LOGW(TAG, "Dallas device 0x%s has invalid CRC.", format_hex(address).c_str());
+    return false;
+  }
+  if (address8[0] != DALLAS_MODEL_DS18S20 && address8[0] != DALLAS_MODEL_DS1822 &&
+      address8[0] != DALLAS_MODEL_DS18B20 && address8[0] != DALLAS_MODEL_DS1825 &&
+      address8[0] != DALLAS_MODEL_DS28EA00) {
+    ESP_LOGW(TAG, "Unknown device type 0x%02X.", address8[0]);
+    return false;
+  }
+  return true;
+}
+
+bool DallasComponent::bind_index_sensor_(DallasTemperatureSensor *sensor) {
+  if (!sensor->get_index().has_value())
+    return true;
+
+  uint8_t index = *sensor->get_index();
+  if (index >= this->devices_.count) {
+    // Left out of the sweeps until a rescan finds enough devices
+    sensor->set_address(0);
+    return false;
+  }
+  sensor->set_address(this->devices_.address[index]);
+  sensor->set_channel(this->devices_.channel[index]);
+  return true;
+}
+
+bool DallasComponent::configure_channel_(uint8_t channel) {
+  bool ok = true;
+  uint8_t copies = 0;
+  for (uint8_t i = this->channel_offset_[channel]; i < this->channel_offset_[channel + 1]; i++) {
+    auto *sensor = this->read_order_[i];
+    // Unbound index sensor, or known to be set up already
+    if (sensor->get_address() == 0 || sensor->configured_)
+      continue;
     if (!sensor->setup_sensor()) {
-      this->status_set_error();
+      ok = false;
+      continue;
+    }
+    this->mark_configured_(sensor);
+    copies += sensor->needs_copy_;
+  }
+  if (copies == 0)
+    return ok;
+
+  // The next reset would abort an EEPROM write in progress, each copy is waited
+  // for. Externally powered devices tell when they are done in a read slot,
+  // parasite devices need the strong pullup for the worst case.
+  bool parasite = this->is_parasite_(channel);
+  for (uint8_t i = this->channel_offset_[channel]; i < this->channel_offset_[channel + 1]; i++) {
+    auto *sensor = this->read_order_[i];
+    if (!sensor->needs_copy_)
+      continue;
+    ok &= sensor->copy_scratch_pad();
+    uint32_t start = millis();
+    if (parasite) {
+      delay(DALLAS_EEPROM_WRITE_MS);
+      continue;
+    }
+    while (!this->wireReadBit() && millis() - start < DALLAS_EEPROM_WRITE_MS)
+      delay(1);
+  }
+  // Ends the strong pullup as well
+  this->wireReset();
+  ESP_LOGD(TAG, "Channel %u: stored the configuration of %u sensors", channel, copies);
+  return ok;
+}
+
+void DallasComponent::mark_configured_(DallasTemperatureSensor *sensor) {
+  sensor->configured_ = true;
+  int16_t index = this->devices_.find(sensor->get_address());
+  if (index >= 0 && this->devices_.config_tag[index] != sensor->config_tag_()) {
+    this->devices_.config_tag[index] = sensor->config_tag_();
+    this->table_dirty_ = true;
+  }
+}
+
+void DallasComponent::start_configure_(uint8_t channel) {
+  this->sweep_state_ = SweepState::CONFIGURE;
+  this->reconfigure_channels_ &= ~(1 << channel);
+  this->config_channel_ = channel;
+  this->config_pos_ = this->channel_offset_[channel];
+  this->config_step_ = ConfigStep::READ;
+  this->config_copies_ = 0;
+}
+
+void DallasComponent::next_configure_transaction_() {
+  uint8_t end = this->channel_offset_[this->config_channel_ + 1];
+  if (this->config_step_ == ConfigStep::READ) {
+    // Unbound index sensor, or known to be set up already
+    while (this->config_pos_ < end && (this->read_order_[this->config_pos_]->get_address() == 0 ||
+                                       this->read_order_[this->config_pos_]->configured_))
+      this->config_pos_++;
+    if (this->config_pos_ >= end) {
+      if (this->config_copies_ != 0)
+        ESP_LOGD(TAG, "Channel %u: stored the configuration of %u sensors", this->config_channel_,
+                 this->config_copies_);
+      this->end_sweep_();
+      return;
     }
   }
 
+  auto *sensor = this->read_order_[this->config_pos_];
+  bool queued = false;
+  switch (this->config_step_) {
+    case ConfigStep::READ:
+    case ConfigStep::VERIFY:
+      queued = sensor->queue_read_scratch_pad();
+      break;
+    case ConfigStep::WRITE:
+      queued = sensor->queue_write_scratch_pad(this->config_block_, this->config_len_);
+      break;
+    case ConfigStep::COPY:
+      queued = sensor->queue_copy_scratch_pad(this->is_parasite_(this->config_channel_));
+      break;
+    case ConfigStep::WAIT:
+      // The device holds the read slots low until its EEPROM write is done
+      if (int32_t(millis() - this->copy_poll_) < 0)
+        return;
+      queued = this->asyncQueue(ASYNC_OP_READ_BIT, 0, &this->copy_bit_);
+      break;
+  }
+  if (!queued) {
+    this->asyncAbort();
+    this->transaction_done_(false);
+  }
+}
+
+void DallasComponent::configure_result_(bool success) {
+  auto *sensor = this->read_order_[this->config_pos_];
+  switch (this->config_step_) {
+    case ConfigStep::READ:
+      if (!success || !sensor->check_scratch_pad()) {
+        ESP_LOGW(TAG, "'%s' - Reading the configuration failed", sensor->get_name().c_str());
+        this->next_configure_sensor_();
+        return;
+      }
+      this->config_len_ = sensor->config_block_(this->config_block_);
+      if (this->config_len_ == 0) {
+        this->mark_configured_(sensor);
+        this->next_configure_sensor_();
+        return;
+      }
+      ESP_LOGD(TAG, "'%s' - Writing configuration", sensor->get_name().c_str());
+      this->config_step_ = ConfigStep::WRITE;
+      return;
+    case ConfigStep::WRITE:
+      if (!success) {
+        this->next_configure_sensor_();
+        return;
+      }
+      this->config_step_ = ConfigStep::VERIFY;
+      return;
+    case ConfigStep::VERIFY:
+      if (!success || !sensor->check_scratch_pad() ||
+          !sensor->config_written_(this->config_block_, this->config_len_)) {
+        ESP_LOGE(TAG, "'%s' - Configuration did not verify", sensor->get_name().c_str());
+        this->next_configure_sensor_();
+        return;
+      }
+      this->config_step_ = ConfigStep::COPY;
+      return;
+    case ConfigStep::COPY:
+      if (!success) {
+        this->next_configure_sensor_();
+        return;
+      }
+      this->mark_configured_(sensor);
+      this->config_copies_++;
+      this->copy_start_ = millis();
+      if (this->is_parasite_(this->config_channel_)) {
+        // Powered by the strong pullup for the worst case, next_transaction_() holds the bus meanwhile
+        this->pullup_active_ = true;
+        this->pullup_until_ = millis() + DALLAS_EEPROM_WRITE_MS;
+        this->next_configure_sensor_();
+        return;
+      }
+      this->copy_poll_ = millis() + DALLAS_EEPROM_POLL_MS;
+      this->config_step_ = ConfigStep::WAIT;
+      return;
+    case ConfigStep::WAIT:
+      if (!(success && this->copy_bit_) && millis() - this->copy_start_ < DALLAS_EEPROM_WRITE_MS) {
+        this->copy_poll_ = millis() + DALLAS_EEPROM_POLL_MS;
+        return;
+      }
+      this->next_configure_sensor_();
+      return;
+  }
+}
+
+void DallasComponent::next_configure_sensor_() {
+  this->config_pos_++;
+  this->config_step_ = ConfigStep::READ;
+}
+
+void DallasComponent::build_read_order_() {
+  this->read_order_.clear();
+  for (uint8_t channel = 0; channel < this->getChannelCount(); channel++) {
+    this->channel_offset_[channel] = this->read_order_.size();
+    for (auto *sensor : this->sensors_) {
+      if (sensor->get_channel() == channel)
+        this->read_order_.push_back(sensor);
+    }
+  }
+  this->channel_offset_[this->getChannelCount()] = this->read_order_.size();
+  this->update_active_channels_();
 }
 
 void DallasComponent::dump_config() {
+#ifndef DALLAS_DS2482_WORKER
+  this->fill_view_(this->view_);
+#endif
+  const HubView &view = this->view_;
   ESP_LOGCONFIG(TAG, "DallasComponent:");
+  ESP_LOGCONFIG(TAG, "  Variant: DS2482-%s", this->getChannelCount() > 1 ? "800" : "100");
   LOG_UPDATE_INTERVAL(this);
+  ESP_LOGCONFIG(TAG, "  Timed transfers: %s", YESNO(this->getTimedMode()));
+  ESP_LOGCONFIG(TAG, "  Rescan: %s", YESNO(this->rescan_));
+  ESP_LOGCONFIG(TAG, "  Alarm search: %s", YESNO(this->alarm_search_));
+  ESP_LOGCONFIG(TAG, "  Continuous conversions: %s", YESNO(this->continuous_));
+#ifdef DALLAS_DS2482_WORKER
+  ESP_LOGCONFIG(TAG, "  Bus work runs in a worker task");
+#endif
+  ESP_LOGCONFIG(TAG, "  Hubs on this I2C bus: %u", this->group_->size());
+  ESP_LOGCONFIG(TAG, "  Active channels: 0x%02X", view.active_channels);
+#ifdef DALLAS_DS2482_TRACE
+  ESP_LOGCONFIG(TAG, "  Trace: %u events, dump with dallas_ds2482.dump_trace", DALLAS_DS2482_TRACE);
+#endif
+  if (this->probe_interval_ != 0)
+    ESP_LOGCONFIG(TAG, "  Probe inactive channels every %" PRIu32 " ms", this->probe_interval_);
+  if (this->conversion_poll_interval_ != 0)
+    ESP_LOGCONFIG(TAG, "  Poll conversions every %u ms", this->conversion_poll_interval_);
+  ESP_LOGCONFIG(TAG, "  Channel selects saved: %" PRIu32, view.channel_selects_saved);
+  ESP_LOGCONFIG(TAG, "  ROM matches resumed: %" PRIu32, view.resumes_used);
+  for (uint8_t channel = 0; channel < this->getChannelCount(); channel++) {
+    if (view.parasite_channels & (1 << channel))
+      ESP_LOGCONFIG(TAG, "  Channel %u: parasite power", channel);
+  }
 
-  if (this->found_sensors_channel_.empty()) {
+  if (view.devices.empty()) {
     ESP_LOGW(TAG, "  Found no sensors!");
   } else {
-    ESP_LOGD(TAG, "  Found sensors:");
-    for (auto &idx : this->found_sensors_channel_) {
-      ESP_LOGD(TAG, "    0x%s", format_hex(idx.address).c_str());
+    ESP_LOGD(TAG, "  Found sensors (%u/%u):", view.devices.count, view.devices.capacity());
+    for (uint16_t i = 0; i < view.devices.count; i++) {
+      ESP_LOGD(TAG, "    0x%s (channel %u)", format_hex(view.devices.address[i]).c_str(), view.devices.channel[i]);
     }
   }
 
@@ -102,74 +753,925 @@ void DallasComponent::dump_config() {
     LOG_SENSOR("  ", "Device", sensor);
     if (sensor->get_index().has_value()) {
       ESP_LOGCONFIG(TAG, "    Index %u", *sensor->get_index());
-      if (*sensor->get_index() >= this->found_sensors_channel_.size()) {
+      if (*sensor->get_index() >= view.devices.count) {
         ESP_LOGE(TAG, "Couldn't find sensor by index - not connected. Proceeding without it.");
         continue;
       }
     }
     ESP_LOGCONFIG(TAG, "    Address: %s", sensor->get_address_name().c_str());
     ESP_LOGCONFIG(TAG, "    Resolution: %u", sensor->get_resolution());
-    ESP_LOGCONFIG(TAG, "    Channel: %u", sensor->get_channel());    
+    ESP_LOGCONFIG(TAG, "    Channel: %u", sensor->shown_channel_());
+    if (sensor->get_update_interval() != 0)
+      ESP_LOGCONFIG(TAG, "    Update interval: %" PRIu32 " ms", sensor->get_update_interval());
   }
 }
 
 void DallasComponent::register_sensor(DallasTemperatureSensor *sensor) { this->sensors_.push_back(sensor); }
 
 void DallasComponent::update() {
-  this->status_clear_warning();
+#ifdef DALLAS_DS2482_WORKER
+  // The worker owns the sweep state, it picks this up with its next step
+  this->update_request_.store(true, std::memory_order_release);
+#else
+  this->handle_update_();
+#endif
+}
 
- for (int8_t channel = 0; channel < 8; channel++){
-  
-  this->setChannel(channel);
+void DallasComponent::dump_trace() {
+#ifdef DALLAS_DS2482_WORKER
+  // The worker writes the trace, it logs it with its next step
+  this->trace_request_.store(true, std::memory_order_release);
+#else
+  this->dumpTrace();
+#endif
+}
 
-  bool result;
-   //   InterruptLock lock;
-    result = this->wireReset();
-  
-  if (!result) {
-     
+void DallasComponent::handle_update_() {
+  if (this->continuous_) {
+    // The channels convert again as soon as they are read, publish what they read
+    // last. The running sweep stops converting and ends with the hub's rescan and
+    // diagnostics, the next one starts right after.
     for (auto *sensor : this->sensors_) {
-      if (sensor->get_channel() == channel){
-        sensor->publish_state(NAN);
-        ESP_LOGE(TAG, "Requested Conversion failed on Channel: %d", channel);
-        this->status_set_warning();        
-      }
+      if (sensor->get_update_interval() == 0)
+        sensor->due_ = true;
     }
-    //return; more channels now - how to handle ?
+    this->publish_latest_();
+    if (this->sweep_state_ == SweepState::IDLE) {
+      this->update_pending_ = true;
+    } else if (!this->hub_sweep_) {
+      this->hub_sweep_ = true;
+      this->set_warning_(false);
+    }
+    return;
+  }
+  if (this->update_pending_) {
+    ESP_LOGW(TAG, "Previous sweep still in progress, skipping update");
+    return;
+  }
+  for (auto *sensor : this->sensors_) {
+    if (sensor->get_update_interval() == 0)
+      sensor->due_ = true;
+  }
+  // A sweep for faster sensors may be running, the next loop() picks this up then
+  this->update_pending_ = true;
+  if (this->sweep_state_ == SweepState::IDLE)
+    this->start_sweep_();
+}
 
-  }    
-  else { 
-    this->wireSkip();
-    this->wireWriteByte(DALLAS_COMMAND_START_CONVERSION);
+void DallasComponent::start_sweep_() {
+  this->hub_sweep_ = this->update_pending_;
+  this->update_pending_ = false;
+  if (this->hub_sweep_)
+    this->set_warning_(false);
+  for (auto *sensor : this->sensors_) {
+    // Unbound index sensors wait for a rescan to find their device
+    sensor->in_sweep_ = sensor->due_ && sensor->get_address() != 0;
+    sensor->due_ = false;
   }
- }
 
+  this->sweep_state_ = SweepState::CONVERT;
+  this->sweep_index_ = 0;
+  this->convert_channels_ = 0xFF;
+  this->convert_failed_ = 0;
+  this->join_pending_ = false;
+  this->read_queue_len_ = 0;
+  this->sweep_bus_start_ = this->getBusStats();
+  this->sweep_start_ = millis();
+  this->sweep_reads_ = 0;
+  this->slice_time_.clear();
+  this->high_freq_.start();
+  this->next_convert_channel_();
+}
+
+bool DallasComponent::schedule_intervals_() {
+  uint32_t now = millis();
+  if (!this->interval_sensors_ || int32_t(now - this->next_interval_due_) < 0)
+    return false;
+
+  bool any = false;
+  uint32_t soonest = UINT32_MAX;
   for (auto *sensor : this->sensors_) {
-    this->set_timeout(sensor->get_address_name(), sensor->millis_to_wait_for_conversion(), [this, sensor] {
+    uint32_t interval = sensor->get_update_interval();
+    if (interval == 0)
+      continue;
+    if (int32_t(now - sensor->next_due_) >= 0) {
+      sensor->due_ = true;
+      any = true;
+      // Keep the cadence, unless we fell more than a whole interval behind
+      sensor->next_due_ += interval;
+      if (int32_t(now - sensor->next_due_) >= 0)
+        sensor->next_due_ = now + interval;
+    }
+    soonest = std::min(soonest, sensor->next_due_ - now);
+  }
+  this->next_interval_due_ = now + soonest;
+  return any;
+}
 
-      this->setChannel(sensor->get_channel());
-      bool res = sensor->read_scratch_pad();
+void DallasComponent::loop() {
+#ifdef DALLAS_DS2482_WORKER
+  // The worker steps the hubs, the main loop only publishes for them
+  this->apply_worker_requests_();
+  if (!this->group_->is_leader(this))
+    return;
+  if (!this->group_->worker_running())
+    this->group_->start_worker();
+  this->group_->drain();
+#else
+  // The group steps all hubs on the bus from its first hub's loop()
+  if (this->group_->is_leader(this))
+    this->group_->loop();
+#endif
+}
 
-      if (!res) {
-        ESP_LOGW(TAG, "'%s' - Resetting bus for read failed!", sensor->get_name().c_str());
-        sensor->publish_state(NAN);
-        this->status_set_warning();
-        return;
+void DallasComponent::publish_(sensor::Sensor *sensor, float value) {
+#ifdef DALLAS_DS2482_WORKER
+  this->group_->publish(sensor, value);
+#else
+  sensor->publish_state(value);
+#endif
+}
+
+void DallasComponent::set_warning_(bool warning) {
+#ifdef DALLAS_DS2482_WORKER
+  this->warning_request_.store(warning ? WARNING_SET : WARNING_CLEAR, std::memory_order_release);
+#else
+  if (warning) {
+    this->status_set_warning();
+  } else {
+    this->status_clear_warning();
+  }
+#endif
+}
+
+bool DallasComponent::step_() {
+#ifdef DALLAS_DS2482_WORKER
+  if (this->update_request_.exchange(false, std::memory_order_acquire))
+    this->handle_update_();
+  if (this->trace_request_.exchange(false, std::memory_order_acquire))
+    this->dumpTrace();
+#endif
+  if (this->sweep_state_ == SweepState::IDLE) {
+    bool due = this->schedule_intervals_();
+    if (this->continuous_) {
+      // Sensors with their own interval publish on it, all of them convert again right away
+      this->publish_latest_();
+      for (auto *sensor : this->sensors_)
+        sensor->due_ = true;
+    } else if (!due && !this->update_pending_ && !this->join_pending_) {
+      // join_pending_: marked due by the last sweep, too late to join it
+      return false;
+    }
+    this->start_sweep_();
+  }
+
+  // Queuing a transaction counts as work too, its first transfer follows right away
+  const ds2482_bus_stats &bus = this->getBusStats();
+  uint32_t transfers = bus.writes + bus.reads;
+  bool was_active = this->asyncActive();
+  this->sweep_step_();
+  return bus.writes + bus.reads != transfers || (!was_active && this->asyncActive());
+}
+
+void DallasComponent::sweep_step_() {
+  switch (this->asyncPoll()) {
+    case DS2482_ASYNC_PENDING:
+      return;
+    case DS2482_ASYNC_DONE:
+      this->transaction_done_(true);
+      break;
+    case DS2482_ASYNC_FAILED:
+      this->transaction_done_(false);
+      break;
+    case DS2482_ASYNC_IDLE:
+    default:
+      this->next_transaction_();
+      break;
+  }
+}
+
+void DallasComponent::push_read_(uint8_t channel, uint32_t due, bool poll) {
+  uint8_t i = this->read_queue_len_++;
+  for (; i > 0 && int32_t(this->read_queue_[i - 1].due - due) > 0; i--)
+    this->read_queue_[i] = this->read_queue_[i - 1];
+  this->read_queue_[i] = {due, channel, poll};
+}
+
+bool DallasComponent::pop_due_read_(PendingRead &read) {
+  if (this->read_queue_len_ == 0 || int32_t(millis() - this->read_queue_[0].due) < 0)
+    return false;
+
+  read = this->read_queue_[0];
+  this->read_queue_len_--;
+  for (uint8_t i = 0; i < this->read_queue_len_; i++)
+    this->read_queue_[i] = this->read_queue_[i + 1];
+  return true;
+}
+
+void DallasComponent::schedule_read_(uint8_t channel) {
+  uint16_t wait = this->channel_wait_[channel];
+  this->convert_start_[channel] = millis();
+
+  // Read slots only tell something after a broadcast: every device on the channel
+  // holds them low until it is done. Parasite devices can't answer at all.
+  if (this->conversion_poll_interval_ == 0 || this->convert_addressed_ || this->is_parasite_(channel)) {
+    this->push_read_(channel, millis() + wait);
+    return;
+  }
+  // Start polling a little before the conversion usually ends
+  uint16_t learned = this->conversion_learned_[channel];
+  uint16_t first = std::min<uint16_t>(learned - learned / 8, wait);
+  this->push_read_(channel, millis() + first, true);
+}
+
+void DallasComponent::poll_result_(bool success) {
+  uint8_t channel = this->read_channel_;
+  uint32_t elapsed = millis() - this->convert_start_[channel];
+  uint16_t wait = this->channel_wait_[channel];
+  this->sweep_state_ = SweepState::READ;
+
+  if (success && this->poll_bit_) {
+    uint16_t &learned = this->conversion_learned_[channel];
+    learned = learned == 0 ? elapsed : (3 * learned + elapsed) / 4;
+    ESP_LOGV(TAG, "Channel %u: conversion done after %" PRIu32 " ms, typically %u ms", channel, elapsed, learned);
+  } else if (elapsed < wait) {
+    // Still converting, or the poll failed: look again, at the latest at the worst case
+    uint32_t next = std::min<uint32_t>(elapsed + this->conversion_poll_interval_, wait);
+    this->push_read_(channel, this->convert_start_[channel] + next, success && next < wait);
+    this->read_channel_ = NO_CHANNEL;
+    return;
+  }
+
+  this->read_pos_ = this->channel_offset_[channel];
+  this->start_alarm_search_();
+}
+
+bool DallasComponent::plan_conversion_(uint8_t channel) {
+  uint8_t begin = this->channel_offset_[channel];
+  uint8_t end = this->channel_offset_[channel + 1];
+  uint8_t due = 0;
+  uint16_t due_wait = 0, all_wait = 0;
+  uint32_t due_hold = 0;
+
+  for (uint8_t i = begin; i < end; i++) {
+    auto *sensor = this->read_order_[i];
+    uint16_t wait = sensor->millis_to_wait_for_conversion();
+    all_wait = std::max(all_wait, wait);
+    if (!sensor->in_sweep_)
+      continue;
+    due++;
+    due_wait = std::max(due_wait, wait);
+    due_hold += wait;
+  }
+  if (due == 0)
+    return false;
+
+  // Bus time in µs: SKIP ROM + CONVERT T once, or MATCH ROM + ROM + CONVERT T per
+  // due sensor. A parasite powered channel is also held for the conversions, all
+  // of them in parallel for a broadcast or one after another when addressed.
+  uint32_t broadcast = this->resetTime() + 16 * this->slotTime();
+  uint32_t addressed = due * (this->resetTime() + 80 * this->slotTime());
+  if (this->is_parasite_(channel)) {
+    broadcast += all_wait * 1000;
+    addressed += due_hold * 1000;
+  }
+  this->convert_hold_ = all_wait;
+  this->convert_addressed_ = due < end - begin && addressed < broadcast;
+  this->convert_pos_ = begin;
+  // The reads only wait for the sensors taking part, not the slowest on the channel
+  this->channel_wait_[channel] = due_wait;
+  return true;
+}
+
+void DallasComponent::next_convert_channel_() {
+  for (; this->sweep_index_ < this->getChannelCount(); this->sweep_index_++) {
+    if ((this->convert_channels_ & (1 << this->sweep_index_)) && this->plan_conversion_(this->sweep_index_))
+      return;
+  }
+  this->sweep_state_ = SweepState::READ;
+  this->read_channel_ = NO_CHANNEL;
+}
+
+bool DallasComponent::join_intervals_() {
+  if (this->schedule_intervals_())
+    this->join_pending_ = true;
+  if (this->continuous_) {
+    // Sensors with their own interval publish on it
+    this->publish_latest_();
+  } else if (!this->join_pending_) {
+    return false;
+  }
+
+  // A channel still waiting for its reads can't convert again, its sensors wait for the
+  // next sweep. Neither does one whose conversion failed, it would fail over and over.
+  uint8_t queued = this->convert_failed_;
+  for (uint8_t i = 0; i < this->read_queue_len_; i++)
+    queued |= 1 << this->read_queue_[i].channel;
+  uint8_t join = 0;
+  bool blocked = false;
+  for (uint8_t channel = 0; channel < this->getChannelCount(); channel++) {
+    uint16_t wait = 0;
+    for (uint8_t i = this->channel_offset_[channel]; i < this->channel_offset_[channel + 1]; i++) {
+      auto *sensor = this->read_order_[i];
+      if (sensor->get_address() == 0)
+        continue;
+      if (!this->continuous_ && (!sensor->due_ || sensor->get_update_interval() == 0))
+        continue;
+      wait = std::max(wait, sensor->millis_to_wait_for_conversion());
+      if (queued & (1 << channel)) {
+        blocked = true;
+      } else {
+        join |= 1 << channel;
+      }
+    }
+    // Running continuously, every channel converts again. Once update() asked for the
+    // sweep to end, only while its reads are done before the slowest channel's.
+    uint32_t last_due = this->read_queue_[this->read_queue_len_ - 1].due;
+    if (this->continuous_ && this->hub_sweep_ && int32_t(millis() + wait - last_due) > 0)
+      join &= ~(1 << channel);
+  }
+  this->join_pending_ = blocked && !this->continuous_;
+  if (join == 0)
+    return false;
+
+  // Sensors following the hub interval stay due for the next hub sweep. Running
+  // continuously, due_ only marks a value to publish.
+  for (uint8_t channel = 0; channel < this->getChannelCount(); channel++) {
+    if (!(join & (1 << channel)))
+      continue;
+    for (uint8_t i = this->channel_offset_[channel]; i < this->channel_offset_[channel + 1]; i++) {
+      auto *sensor = this->read_order_[i];
+      if (this->continuous_) {
+        sensor->in_sweep_ = sensor->get_address() != 0;
+        continue;
+      }
+      sensor->in_sweep_ = sensor->due_ && sensor->get_update_interval() != 0 && sensor->get_address() != 0;
+      if (sensor->in_sweep_)
+        sensor->due_ = false;
+    }
+  }
+  this->convert_channels_ = join;
+  this->sweep_state_ = SweepState::CONVERT;
+  this->sweep_index_ = 0;
+  this->next_convert_channel_();
+  return true;
+}
+
+void DallasComponent::next_transaction_() {
+  if (this->pullup_active_) {
+    // Parasite devices are converting on the strong pullup, the bus and the
+    // channel selection stay as they are until they are done
+    if (int32_t(millis() - this->pullup_until_) < 0) {
+      this->high_freq_.stop();
+      return;
+    }
+    this->high_freq_.start();
+    this->pullup_active_ = false;
+    // Ended like any other step, one transfer per poll; transaction_done_() skips its result
+    this->pullup_release_ = true;
+    this->asyncQueue(ASYNC_OP_PULLUP, 0);
+    return;
+  }
+
+  if (this->sweep_state_ == SweepState::CONVERT) {
+    uint8_t channel = this->sweep_index_;
+    bool parasite = this->is_parasite_(channel);
+    if (this->convert_addressed_) {
+      while (!this->read_order_[this->convert_pos_]->in_sweep_)
+        this->convert_pos_++;
+      if (!this->read_order_[this->convert_pos_]->queue_conversion(parasite)) {
+        this->asyncAbort();
+        this->transaction_done_(false);
       }
-      if (!sensor->check_scratch_pad()) {
-        sensor->publish_state(NAN);
-        this->status_set_warning();
+      return;
+    }
+    this->asyncQueue(ASYNC_OP_CHANNEL, channel);
+    this->asyncQueue(ASYNC_OP_RESET);
+    this->asyncQueue(ASYNC_OP_WRITE, WIRE_COMMAND_SKIP);
+    if (parasite)
+      this->asyncQueue(ASYNC_OP_PULLUP, 1);
+    this->asyncQueue(ASYNC_OP_WRITE, DALLAS_COMMAND_START_CONVERSION);
+    return;
+  }
+
+  if (this->sweep_state_ == SweepState::PROBE) {
+    this->asyncQueue(ASYNC_OP_CHANNEL, this->probe_channel_);
+    this->asyncQueue(ASYNC_OP_RESET, 1);
+    return;
+  }
+
+  if (this->sweep_state_ == SweepState::POWER) {
+    if (!this->channel_populated_(this->power_channel_)) {
+      this->end_sweep_();
+      return;
+    }
+    this->asyncQueue(ASYNC_OP_CHANNEL, this->power_channel_);
+    this->asyncQueue(ASYNC_OP_RESET);
+    this->asyncQueue(ASYNC_OP_WRITE, WIRE_COMMAND_SKIP);
+    this->asyncQueue(ASYNC_OP_WRITE, DALLAS_COMMAND_READ_POWER_SUPPLY);
+    this->asyncQueue(ASYNC_OP_READ_BIT, 0, &this->power_bit_);
+    return;
+  }
+
+  if (this->sweep_state_ == SweepState::CONFIGURE) {
+    this->next_configure_transaction_();
+    return;
+  }
+
+  if (this->sweep_state_ == SweepState::SCAN) {
+    if (this->wireSearchDone() && !this->next_scan_family_()) {
+      this->finish_scan_(true);
+      return;
+    }
+    // The refresh goes over empty channels too, no presence there is no error
+    this->queue_search_(this->scan_channel_, WIRE_COMMAND_SEARCH, this->refresh_channels_ != 0);
+    return;
+  }
+
+  if (this->sweep_state_ == SweepState::ALARM) {
+    if (!this->wireSearchDone()) {
+      this->queue_search_(this->read_channel_, ALARM_SEARCH);
+      return;
+    }
+    this->sweep_state_ = SweepState::READ;
+  }
+
+  if (this->read_channel_ == NO_CHANNEL) {
+    // Due sensors on channels this sweep is done with convert now, not after the slowest channel
+    if (this->read_queue_len_ != 0 && this->join_intervals_())
+      return;
+    if (this->read_queue_len_ == 0) {
+      if (!this->hub_sweep_ || !this->start_background_scan_())
+        this->end_sweep_();
+      return;
+    }
+    // Nothing to do on the bus until the earliest window opens. The regular loop
+    // cadence is enough to notice that, so let the main loop idle meanwhile.
+    PendingRead read;
+    if (!this->pop_due_read_(read)) {
+      this->high_freq_.stop();
+      return;
+    }
+    this->high_freq_.start();
+    this->read_channel_ = read.channel;
+    if (read.poll) {
+      this->sweep_state_ = SweepState::POLL;
+      this->asyncQueue(ASYNC_OP_CHANNEL, read.channel);
+      this->asyncQueue(ASYNC_OP_READ_BIT, 0, &this->poll_bit_);
+      return;
+    }
+    this->read_pos_ = this->channel_offset_[this->read_channel_];
+    if (this->start_alarm_search_())
+      return;
+  }
+
+  // Sensors polled by exception are only read when their alarm flag is set
+  uint8_t end = this->channel_offset_[this->read_channel_ + 1];
+  while (this->read_pos_ < end && !this->needs_read_(this->read_order_[this->read_pos_]))
+    this->read_pos_++;
+  if (this->read_pos_ >= end) {
+    this->read_channel_ = NO_CHANNEL;
+    return;
+  }
+
+  auto *sensor = this->read_order_[this->read_pos_];
+  if (!sensor->queue_read_scratch_pad()) {
+    this->asyncAbort();
+    this->transaction_done_(false);
+  }
+}
+
+void DallasComponent::transaction_done_(bool success) {
+  if (this->pullup_release_) {
+    // A failure leaves the config unknown, the next pullup step reads it again
+    this->pullup_release_ = false;
+    return;
+  }
+  if (this->sweep_state_ == SweepState::CONVERT) {
+    uint8_t channel = this->sweep_index_;
+    uint8_t end = this->channel_offset_[channel + 1];
+    if (this->is_parasite_(channel)) {
+      // Hold the strong pullup for the conversion, release it right away after a failure
+      uint16_t hold = this->convert_addressed_ ? this->read_order_[this->convert_pos_]->millis_to_wait_for_conversion()
+                                               : this->convert_hold_;
+      this->pullup_active_ = true;
+      this->pullup_until_ = millis() + (success ? hold : 0);
+    }
+    if (this->convert_addressed_) {
+      if (!success)
+        this->conversion_failed_(this->convert_pos_, this->convert_pos_ + 1);
+      this->convert_pos_++;
+      while (this->convert_pos_ < end && !this->read_order_[this->convert_pos_]->in_sweep_)
+        this->convert_pos_++;
+      if (this->convert_pos_ < end)
         return;
+    } else if (!success) {
+      this->conversion_failed_(this->channel_offset_[channel], end);
+    }
+
+    // Read once the last conversion started on the channel is done
+    for (uint8_t i = this->channel_offset_[channel]; i < end; i++) {
+      if (this->read_order_[i]->in_sweep_) {
+        this->schedule_read_(channel);
+        break;
+      }
+    }
+    this->sweep_index_++;
+    this->next_convert_channel_();
+    return;
+  }
+
+  if (this->sweep_state_ == SweepState::SCAN) {
+    this->scan_result_(success);
+    return;
+  }
+  if (this->sweep_state_ == SweepState::PROBE) {
+    if (success) {
+      ESP_LOGI(TAG, "Channel %u: devices attached, scanning", this->probe_channel_);
+      this->start_scan_(this->probe_channel_);
+    } else {
+      this->end_sweep_();
+    }
+    return;
+  }
+  if (this->sweep_state_ == SweepState::ALARM) {
+    this->alarm_result_(success);
+    return;
+  }
+  if (this->sweep_state_ == SweepState::POWER) {
+    this->power_result_(success);
+    return;
+  }
+  if (this->sweep_state_ == SweepState::CONFIGURE) {
+    this->configure_result_(success);
+    return;
+  }
+  if (this->sweep_state_ == SweepState::POLL) {
+    this->poll_result_(success);
+    return;
+  }
+
+  this->process_reading_(this->read_order_[this->read_pos_], success);
+  this->sweep_reads_++;
+  this->group_->count_read();
+  if (++this->read_pos_ >= this->channel_offset_[this->read_channel_ + 1])
+    this->read_channel_ = NO_CHANNEL;
+}
+
+void DallasComponent::conversion_failed_(uint8_t begin, uint8_t end) {
+  for (uint8_t i = begin; i < end; i++) {
+    auto *sensor = this->read_order_[i];
+    if (!sensor->in_sweep_)
+      continue;
+    sensor->in_sweep_ = false;
+    this->convert_failed_ |= 1 << sensor->get_channel();
+    // A cached device that moved away may have left its channel empty
+    if (this->unverified_ != 0)
+      this->verify_cached_(sensor, false);
+    this->deliver_(sensor, NAN);
+    ESP_LOGE(TAG, "Requested Conversion failed on Channel: %d", sensor->get_channel());
+    this->set_warning_(true);
+  }
+}
+
+void DallasComponent::process_reading_(DallasTemperatureSensor *sensor, bool success) {
+  if (!success)
+    ESP_LOGW(TAG, "'%s' - Resetting bus for read failed!", sensor->get_name().c_str());
+  // With other devices left on its channel, a moved device shows as a garbled reply
+  bool valid = success && sensor->check_scratch_pad();
+  sensor->alarm_skips_ = 0;
+  if (this->unverified_ != 0)
+    this->verify_cached_(sensor, valid);
+  if (!valid) {
+    this->deliver_(sensor, NAN);
+    this->set_warning_(true);
+    return;
+  }
+
+  float tempc = sensor->get_temp_c();
+  ESP_LOGV(TAG, "'%s': Got Temperature=%.1f°C", sensor->get_name().c_str(), tempc);
+  this->deliver_(sensor, tempc);
+}
+
+void DallasComponent::deliver_(DallasTemperatureSensor *sensor, float value) {
+  sensor->latest_.store(value, std::memory_order_relaxed);
+  sensor->has_latest_.store(true, std::memory_order_release);
+  if (!this->continuous_)
+    this->publish_(sensor, value);
+}
+
+void DallasComponent::publish_latest_() {
+  for (auto *sensor : this->sensors_) {
+    // Nothing read yet, the sensor publishes on the first due after its first reading
+    if (!sensor->due_ || !sensor->has_latest())
+      continue;
+    sensor->due_ = false;
+    this->publish_(sensor, sensor->get_latest());
+  }
+}
+
+void DallasComponent::queue_search_(uint8_t channel, uint8_t command, bool probe) {
+  this->asyncQueue(ASYNC_OP_CHANNEL, channel);
+  this->asyncQueue(ASYNC_OP_RESET, probe);
+  this->asyncQueue(ASYNC_OP_WRITE, command);
+  this->asyncQueue(ASYNC_OP_SEARCH, 0, reinterpret_cast<uint8_t *>(&this->scan_address_));
+}
+
+bool DallasComponent::next_scan_family_() {
+  if (++this->scan_family_ >= DALLAS_TEMPERATURE_FAMILY_COUNT)
+    return false;
+  this->wireTargetSearch(DALLAS_TEMPERATURE_FAMILIES[this->scan_family_]);
+  return true;
+}
+
+bool DallasComponent::needs_read_(DallasTemperatureSensor *sensor) {
+  if (!sensor->in_sweep_)
+    return false;
+  if (!this->alarm_search_ || !sensor->has_alarm() || sensor->is_alarm_tripped() || !sensor->has_latest())
+    return true;
+  // The value moves within the thresholds too, read it now and then to keep it current
+  return ++sensor->alarm_skips_ >= DALLAS_ALARM_FULL_READ;
+}
+
+bool DallasComponent::start_alarm_search_() {
+  if (!this->alarm_search_)
+    return false;
+
+  bool any = false;
+  for (uint8_t i = this->read_pos_; i < this->channel_offset_[this->read_channel_ + 1]; i++) {
+    auto *sensor = this->read_order_[i];
+    if (!sensor->in_sweep_)
+      continue;
+    sensor->set_alarm_tripped(false);
+    any |= sensor->has_alarm() && sensor->has_latest();
+  }
+  if (!any)
+    return false;
+
+  this->sweep_state_ = SweepState::ALARM;
+  this->mError = 0;
+  this->wireResetSearch();
+  return true;
+}
+
+void DallasComponent::alarm_result_(bool success) {
+  uint8_t begin = this->channel_offset_[this->read_channel_];
+  uint8_t end = this->channel_offset_[this->read_channel_ + 1];
+
+  if (!success) {
+    // No device in alarm ends the search as well, only a bus error forces full reads
+    if (this->mError != 0) {
+      for (uint8_t i = begin; i < end; i++)
+        this->read_order_[i]->set_alarm_tripped(true);
+    }
+    this->sweep_state_ = SweepState::READ;
+    return;
+  }
+
+  for (uint8_t i = begin; i < end; i++) {
+    if (this->read_order_[i]->get_address() == this->scan_address_)
+      this->read_order_[i]->set_alarm_tripped(true);
+  }
+}
+
+bool DallasComponent::start_background_scan_() {
+  uint8_t inactive = ((1 << this->getChannelCount()) - 1) & ~this->active_channels_;
+  if (this->probe_interval_ != 0 && inactive != 0 && millis() - this->last_probe_ >= this->probe_interval_) {
+    // An empty channel costs one reset per probe, not a search per sweep
+    this->last_probe_ = millis();
+    this->probe_channel_ = this->next_channel_(inactive, this->probe_channel_);
+    this->sweep_state_ = SweepState::PROBE;
+    return true;
+  }
+  if (this->rescan_ && this->active_channels_ != 0) {
+    this->rescan_channel_ = this->next_channel_(this->active_channels_, this->rescan_channel_);
+    this->start_scan_(this->rescan_channel_);
+    return true;
+  }
+  return false;
+}
+
+uint8_t DallasComponent::next_channel_(uint8_t mask, uint8_t after) const {
+  for (uint8_t i = 1; i <= this->getChannelCount(); i++) {
+    uint8_t channel = (after + i) % this->getChannelCount();
+    if (mask & (1 << channel))
+      return channel;
+  }
+  return after;
+}
+
+void DallasComponent::update_active_channels_() {
+  this->active_channels_ = 0;
+  for (uint8_t channel = 0; channel < this->getChannelCount(); channel++) {
+    if (this->channel_offset_[channel + 1] != this->channel_offset_[channel])
+      this->active_channels_ |= 1 << channel;
+  }
+  for (uint16_t i = 0; i < this->devices_.count; i++)
+    this->active_channels_ |= 1 << this->devices_.channel[i];
+}
+
+void DallasComponent::start_scan_(uint8_t channel) {
+  this->sweep_state_ = SweepState::SCAN;
+  this->scan_channel_ = channel;
+  this->scan_found_ = 0;
+  this->mError = 0;
+  this->scan_family_ = 0;
+  this->wireTargetSearch(DALLAS_TEMPERATURE_FAMILIES[0]);
+  for (uint16_t i = 0; i < this->devices_.count; i++)
+    this->devices_.state[i] &= ~DEVICE_STATE_SEEN;
+}
+
+void DallasComponent::scan_result_(bool success) {
+  if (!success) {
+    // The targeted search ran past its family
+    if (this->wireSearchDone() && this->mError == 0)
+      return;
+    // A missing presence pulse on the first pass means the channel is empty now,
+    // anything else is a bus problem and the channel is left as it was
+    this->finish_scan_(this->scan_found_ == 0 && this->mError == 0);
+    return;
+  }
+
+  uint64_t address = this->scan_address_;
+  this->scan_found_++;
+  if (!this->valid_address_(address))
+    return;
+
+  int16_t index = this->devices_.find(address);
+  if (index >= 0 && this->devices_.channel[index] == this->scan_channel_) {
+    this->devices_.state[index] |= DEVICE_STATE_SEEN;
+    return;
+  }
+  if (index >= 0) {
+    // Moved to another channel
+    this->devices_.remove(index);
+  }
+  index = this->devices_.add(address, this->scan_channel_);
+  if (index < 0) {
+    ESP_LOGW(TAG, "Device table full (%u devices), ignoring 0x%s.", this->devices_.capacity(),
+             format_hex(address).c_str());
+    return;
+  }
+  this->devices_.state[index] |= DEVICE_STATE_SEEN;
+  this->scan_changed_ = true;
+  ESP_LOGI(TAG, "Channel %u: new device 0x%s", this->scan_channel_, format_hex(address).c_str());
+}
+
+void DallasComponent::finish_scan_(bool complete) {
+  if (complete) {
+    for (uint16_t i = 0; i < this->devices_.count;) {
+      if (this->devices_.channel[i] == this->scan_channel_ && !(this->devices_.state[i] & DEVICE_STATE_SEEN)) {
+        ESP_LOGI(TAG, "Channel %u: device 0x%s is gone", this->scan_channel_,
+                 format_hex(this->devices_.address[i]).c_str());
+        this->devices_.remove(i);
+        this->scan_changed_ = true;
+        continue;
       }
+      i++;
+    }
+  }
+
+  bool refreshing = this->refresh_channels_ != 0;
+  if (this->scan_changed_) {
+    this->devices_.sort();
+    // Both done by the sweep, after the scan: sensors on devices found only now are not set up yet
+    this->power_channels_ |= 1 << this->scan_channel_;
+    this->reconfigure_channels_ |= 1 << this->scan_channel_;
+    // A refresh rebinds once all channels are scanned, a moved device is missing in between
+    if (!refreshing)
+      this->rebind_sensors_();
+    this->scan_changed_ = false;
+    this->table_dirty_ = true;
+  }
+
+  if (refreshing) {
+    this->refresh_channels_ &= ~(1 << this->scan_channel_);
+    if (this->refresh_channels_ != 0) {
+      this->start_scan_(this->next_channel_(this->refresh_channels_, this->scan_channel_));
+      return;
+    }
+    ESP_LOGI(TAG, "Scanned all channels, %u devices", this->devices_.count);
+    this->rebind_sensors_();
+    // The cached configuration can't be trusted either
+    for (auto *sensor : this->sensors_)
+      sensor->configured_ = false;
+    this->reconfigure_channels_ = (1 << this->getChannelCount()) - 1;
+    this->table_dirty_ = true;
+  }
+  this->end_sweep_();
+}
+
+void DallasComponent::rebind_sensors_() {
+  uint8_t moved = 0;
+  for (auto *sensor : this->sensors_) {
+    if (!sensor->get_index().has_value())
+      continue;
+    uint64_t old_address = sensor->get_address();
+    if (!this->bind_index_sensor_(sensor)) {
+      ESP_LOGW(TAG, "'%s' - index %u is no longer connected", sensor->get_name().c_str(), *sensor->get_index());
+      continue;
+    }
+    if (sensor->get_address() != old_address) {
+      ESP_LOGI(TAG, "'%s' - index %u is now 0x%s on channel %u", sensor->get_name().c_str(), *sensor->get_index(),
+               format_hex(sensor->get_address()).c_str(), sensor->get_channel());
+      sensor->configured_ = false;
+      moved |= 1 << sensor->get_channel();
+    }
+  }
+  this->build_read_order_();
+  // Set up at the end of the sweep
+  this->reconfigure_channels_ |= moved;
+}
 
-      float tempc = sensor->get_temp_c();
-      ESP_LOGD(TAG, "'%s': Got Temperature=%.1f°C", sensor->get_name().c_str(), tempc);
-      sensor->publish_state(tempc);
-    });
+void DallasComponent::end_sweep_() {
+  if (this->cache_stale_) {
+    // Part of this sweep: the scans run one transfer per step like everything else
+    this->start_refresh_();
+    return;
+  }
+  // Before the configuration: parasite devices copy to EEPROM on the strong pullup
+  if (this->power_channels_ != 0) {
+    this->start_power_check_();
+    return;
+  }
+  if (this->reconfigure_channels_ != 0) {
+    this->start_configure_(this->next_channel_(this->reconfigure_channels_, this->getChannelCount() - 1));
+    return;
+  }
+  this->sweep_state_ = SweepState::IDLE;
+  this->high_freq_.stop();
+  if (this->persist_devices_ && this->table_dirty_)
+    this->save_devices_();
+#ifdef DALLAS_DS2482_WORKER
+  this->publish_view_();
+#endif
+  // Sweeps of fast interval sensors would flood the log
+  if (this->hub_sweep_) {
+    this->log_sweep_stats_();
+    this->publish_diagnostics_(millis() - this->sweep_start_);
   }
 }
 
-void DallasTemperatureSensor::set_address(uint64_t address) { this->address_ = address;}
+void DallasComponent::publish_diagnostics_(uint32_t sweep_duration) {
+  const ds2482_bus_stats &bus = this->getBusStats();
+  uint32_t no_presence = 0, shorts = 0, crc_errors = 0;
+
+  // The counters only grow, a float can't hold them exactly past 2^24: publish
+  // what was added since the last hub sweep instead
+  for (uint8_t channel = 0; channel < this->getChannelCount(); channel++) {
+    const ds2482_channel_stats &stats = this->getChannelStats(channel);
+    no_presence += stats.noPresence;
+    shorts += stats.shorts;
+    crc_errors += stats.crcErrors;
+    uint32_t errors = stats.noPresence + stats.shorts + stats.crcErrors;
+    if (this->channel_error_sensors_[channel] != nullptr)
+      this->publish_(this->channel_error_sensors_[channel], errors - this->channel_errors_published_[channel]);
+    this->channel_errors_published_[channel] = errors;
+  }
+
+  const uint32_t counters[DIAGNOSTIC_SWEEP_DURATION] = {
+      bus.writes + bus.reads, bus.statusPolls, bus.timeouts, crc_errors, no_presence, shorts,
+  };
+  for (uint8_t i = 0; i < DIAGNOSTIC_SWEEP_DURATION; i++) {
+    if (this->diagnostic_sensors_[i] != nullptr)
+      this->publish_(this->diagnostic_sensors_[i], counters[i] - this->counters_published_[i]);
+    this->counters_published_[i] = counters[i];
+  }
+  if (this->diagnostic_sensors_[DIAGNOSTIC_SWEEP_DURATION] != nullptr)
+    this->publish_(this->diagnostic_sensors_[DIAGNOSTIC_SWEEP_DURATION], sweep_duration);
+  if (this->diagnostic_sensors_[DIAGNOSTIC_BUS_THROUGHPUT] != nullptr)
+    this->publish_(this->diagnostic_sensors_[DIAGNOSTIC_BUS_THROUGHPUT], this->group_->throughput());
+}
+
+void DallasComponent::log_sweep_stats_() {
+  const ds2482_bus_stats &bus = this->getBusStats();
+  uint32_t transfers = bus.writes + bus.reads - this->sweep_bus_start_.writes - this->sweep_bus_start_.reads;
+  uint32_t bytes = bus.bytes - this->sweep_bus_start_.bytes;
+  uint16_t reads = std::max<uint16_t>(this->sweep_reads_, 1);
+
+  ESP_LOGD(TAG,
+           "Sweep: %u sensors in %" PRIu32 " ms, %" PRIu32 " I2C transfers (%" PRIu32 "/sensor), %" PRIu32
+           " bytes, %" PRIu32 " us busy waiting",
+           this->sweep_reads_, millis() - this->sweep_start_, transfers, transfers / reads, bytes,
+           bus.busyWaitUs - this->sweep_bus_start_.busyWaitUs);
+  ESP_LOGD(TAG, "Bus: %u hubs, %.1f sensors/s", this->group_->size(), this->group_->throughput());
+  // Once per bus, it covers the other devices on it as well
+  if (this->group_->is_leader(this))
+    this->getArbiter()->log_stats();
+  ESP_LOGD(TAG, "Sweep loop blocking: %u slices, p50 <= %" PRIu32 " us, p99 <= %" PRIu32 " us, max %" PRIu32 " us",
+           this->slice_time_.total, this->slice_time_.percentile(50), this->slice_time_.percentile(99),
+           this->slice_time_.max);
+#ifdef DALLAS_DS2482_WORKER
+  if (this->group_->dropped() != 0)
+    ESP_LOGW(TAG, "Worker: %" PRIu32 " values dropped, the main loop fell behind", this->group_->dropped());
+#endif
+}
+
+void DallasTemperatureSensor::set_address(uint64_t address) { this->address_ = address; }
+uint64_t DallasTemperatureSensor::get_address() const { return this->address_; }
+void DallasTemperatureSensor::set_alarm_high(int8_t alarm_high) { this->alarm_high_ = alarm_high; }
+void DallasTemperatureSensor::set_alarm_low(int8_t alarm_low) { this->alarm_low_ = alarm_low; }
+bool DallasTemperatureSensor::has_alarm() const { return this->alarm_high_.has_value() || this->alarm_low_.has_value(); }
 void DallasTemperatureSensor::set_channel(uint8_t channel) { channel_ = channel;}  
 uint8_t DallasTemperatureSensor::get_channel() { return channel_;}
 uint8_t DallasTemperatureSensor::get_resolution() const { return this->resolution_; }
@@ -177,9 +1679,18 @@ void DallasTemperatureSensor::set_resolution(uint8_t resolution) { this->resolut
 optional<uint8_t> DallasTemperatureSensor::get_index() const { return this->index_; }
 void DallasTemperatureSensor::set_index(uint8_t index) { this->index_ = index; }
 uint8_t *DallasTemperatureSensor::get_address8() { return reinterpret_cast<uint8_t *>(&this->address_); }
+#ifdef DALLAS_DS2482_WORKER
+uint64_t DallasTemperatureSensor::shown_address_() const { return this->view_address_; }
+uint8_t DallasTemperatureSensor::shown_channel_() const { return this->view_channel_; }
+#else
+uint64_t DallasTemperatureSensor::shown_address_() const { return this->address_; }
+uint8_t DallasTemperatureSensor::shown_channel_() const { return this->channel_; }
+#endif
 const std::string &DallasTemperatureSensor::get_address_name() {
-  if (this->address_name_.empty()) {
-    this->address_name_ = std::string("0x") + format_hex(this->address_);
+  uint64_t address = this->shown_address_();
+  if (this->address_name_.empty() || this->named_address_ != address) {
+    this->address_name_ = std::string("0x") + format_hex(address);
+    this->named_address_ = address;
   }
 
   return this->address_name_;
@@ -187,79 +1698,132 @@ const std::string &DallasTemperatureSensor::get_address_name() {
 bool IRAM_ATTR DallasTemperatureSensor::read_scratch_pad() {
     auto *wire = this->parent_;
     wire->setChannel(this->get_channel());
-        
-    if (!wire->wireReset()) {
-      return false;
-    }
 
-    wire->wireSelect(this->address_);
-    wire->wireWriteByte(DALLAS_COMMAND_READ_SCRATCH_PAD);
+  return wire->wireSelectAndRead(this->address_, DALLAS_COMMAND_READ_SCRATCH_PAD, this->scratch_pad_,
+                                 sizeof(this->scratch_pad_));
+}
 
-    for (unsigned char &i : this->scratch_pad_) {
-      i = wire->wireReadByte();
-    }
+bool DallasTemperatureSensor::queue_read_scratch_pad() {
+  auto *wire = this->parent_;
 
-  return true;
+  // The channel step is free when the channel window is already open
+  return wire->asyncQueue(ASYNC_OP_CHANNEL, this->get_channel()) && wire->asyncQueue(ASYNC_OP_RESET) &&
+         wire->asyncQueueSelect(&this->address_) && wire->asyncQueue(ASYNC_OP_WRITE, DALLAS_COMMAND_READ_SCRATCH_PAD) &&
+         wire->asyncQueue(ASYNC_OP_READ, sizeof(this->scratch_pad_), this->scratch_pad_);
 }
 
-bool DallasTemperatureSensor::setup_sensor() {
-  bool r = this->read_scratch_pad();
+bool DallasTemperatureSensor::queue_conversion(bool strong_pullup) {
+  auto *wire = this->parent_;
+
+  return wire->asyncQueue(ASYNC_OP_CHANNEL, this->get_channel()) && wire->asyncQueue(ASYNC_OP_RESET) &&
+         wire->asyncQueueSelect(&this->address_) && (!strong_pullup || wire->asyncQueue(ASYNC_OP_PULLUP, 1)) &&
+         wire->asyncQueue(ASYNC_OP_WRITE, DALLAS_COMMAND_START_CONVERSION);
+}
+
+uint8_t DallasTemperatureSensor::config_register_() const {
+  switch (this->resolution_) {
+    case 12:
+      return 0x7F;
+    case 11:
+      return 0x5F;
+    case 10:
+      return 0x3F;
+    case 9:
+    default:
+      return 0x1F;
+  }
+}
 
-  if (!r) {
+bool DallasTemperatureSensor::setup_sensor() {
+  this->needs_copy_ = false;
+  if (!this->read_scratch_pad()) {
     ESP_LOGE(TAG, "Reading scratchpad failed: reset");
     return false;
   }
   if (!this->check_scratch_pad())
     return false;
 
-  if (this->scratch_pad_[4] == this->resolution_)
+  uint8_t block[4];
+  uint8_t len = this->config_block_(block);
+  if (len == 0)
+    return true;
+
+  ESP_LOGD(TAG, "'%s' - Writing configuration", this->get_name().c_str());
+  auto *wire = this->parent_;
+  wire->setChannel(this->get_channel());
+  if (!wire->wireReset())
     return false;
+  wire->wireSelect(this->address_);
+  wire->wireWriteBlock(block, len);
 
-  if (this->get_address8()[0] == DALLAS_MODEL_DS18S20) {
-    // DS18S20 doesn't support resolution.
-    ESP_LOGW(TAG, "DS18S20 doesn't support setting resolution.");
+  // Only a scratch pad that reads back as written goes to EEPROM
+  if (!this->read_scratch_pad() || !this->check_scratch_pad() || !this->config_written_(block, len)) {
+    ESP_LOGE(TAG, "'%s' - Configuration did not verify", this->get_name().c_str());
     return false;
   }
+  this->needs_copy_ = true;
+  return true;
+}
 
-  switch (this->resolution_) {
-    case 12:
-      this->scratch_pad_[4] = 0x7F;
-      break;
-    case 11:
-      this->scratch_pad_[4] = 0x5F;
-      break;
-    case 10:
-      this->scratch_pad_[4] = 0x3F;
-      break;
-    case 9:
-    default:
-      this->scratch_pad_[4] = 0x1F;
-      break;
-  }
+uint8_t DallasTemperatureSensor::config_tag_() const {
+  uint8_t config[5] = {this->resolution_, this->alarm_high_.has_value(),
+                       uint8_t(this->alarm_high_.value_or(0)), this->alarm_low_.has_value(),
+                       uint8_t(this->alarm_low_.value_or(0))};
+  return crc8(config, sizeof(config));
+}
 
-  auto *wire = this->parent_;
-  wire->setChannel(this->get_channel());  
-  {
+uint8_t DallasTemperatureSensor::config_block_(uint8_t *block) const {
+  bool ds18s20 = (this->address_ & 0xFF) == DALLAS_MODEL_DS18S20;
+  // high alarm temp, low alarm temp, resolution (not on DS18S20)
+  block[0] = DALLAS_COMMAND_WRITE_SCRATCH_PAD;
+  block[1] = this->alarm_high_.has_value() ? uint8_t(*this->alarm_high_) : this->scratch_pad_[2];
+  block[2] = this->alarm_low_.has_value() ? uint8_t(*this->alarm_low_) : this->scratch_pad_[3];
+  // DS18S20 has no configuration register and always converts at 9 bit
+  block[3] = ds18s20 ? this->scratch_pad_[4] : this->config_register_();
+  uint8_t len = ds18s20 ? 3 : 4;
+  return this->config_written_(block, len) ? 0 : len;
+}
 
-    if (wire->wireReset()) {
-      wire->wireSelect(this->address_);
-      wire->wireWriteByte(DALLAS_COMMAND_WRITE_SCRATCH_PAD);
-      wire->wireWriteByte(this->scratch_pad_[2]);  // high alarm temp
-      wire->wireWriteByte(this->scratch_pad_[3]);  // low alarm temp
-      wire->wireWriteByte(this->scratch_pad_[4]);  // resolution
-      wire->wireReset();
+bool DallasTemperatureSensor::config_written_(const uint8_t *block, uint8_t len) const {
+  return memcmp(block + 1, this->scratch_pad_ + 2, len - 1) == 0;
+}
 
-      // write value to EEPROM
-      wire->wireSelect(this->address_);
-      wire->wireWriteByte(0x48);
-    }
-  }
+bool DallasTemperatureSensor::config_matches_() const {
+  if (this->alarm_high_.has_value() && int8_t(this->scratch_pad_[2]) != *this->alarm_high_)
+    return false;
+  if (this->alarm_low_.has_value() && int8_t(this->scratch_pad_[3]) != *this->alarm_low_)
+    return false;
+  return (this->address_ & 0xFF) == DALLAS_MODEL_DS18S20 || this->scratch_pad_[4] == this->config_register_();
+}
 
-  delay(20);  // allow it to finish operation
-  wire->wireReset();
+bool DallasTemperatureSensor::copy_scratch_pad() {
+  auto *wire = this->parent_;
+  wire->setChannel(this->get_channel());
+  if (!wire->wireReset())
+    return false;
+  wire->wireSelect(this->address_);
+  // Parasite devices need the strong pullup for the EEPROM write
+  wire->wireWriteByte(DALLAS_COMMAND_COPY_SCRATCH_PAD, wire->is_parasite_(this->channel_));
+  this->needs_copy_ = false;
   return true;
 }
 
+bool DallasTemperatureSensor::queue_write_scratch_pad(uint8_t *block, uint8_t len) {
+  auto *wire = this->parent_;
+
+  return wire->asyncQueue(ASYNC_OP_CHANNEL, this->get_channel()) && wire->asyncQueue(ASYNC_OP_RESET) &&
+         wire->asyncQueueSelect(&this->address_) &&
+         wire->asyncQueue(ASYNC_OP_WRITE_BLOCK, len, block);
+}
+
+bool DallasTemperatureSensor::queue_copy_scratch_pad(bool strong_pullup) {
+  auto *wire = this->parent_;
+
+  return wire->asyncQueue(ASYNC_OP_CHANNEL, this->get_channel()) && wire->asyncQueue(ASYNC_OP_RESET) &&
+         wire->asyncQueueSelect(&this->address_) && (!strong_pullup || wire->asyncQueue(ASYNC_OP_PULLUP, 1)) &&
+         wire->asyncQueue(ASYNC_OP_WRITE, DALLAS_COMMAND_COPY_SCRATCH_PAD);
+}
+
 bool DallasTemperatureSensor::check_scratch_pad() {
   bool chksum_validity = (crc8(this->scratch_pad_, 8) == this->scratch_pad_[8]);
   bool config_validity = false;
@@ -279,6 +1843,7 @@ bool DallasTemperatureSensor::check_scratch_pad() {
             crc8(this->scratch_pad_, 8));
 #endif
   if (!chksum_validity) {
+    this->parent_->recordCrcError(this->channel_);
     ESP_LOGW(TAG, "'%s' - Scratch pad checksum invalid!", this->get_name().c_str());     
   } else if (!config_validity) {
     ESP_LOGW(TAG, "'%s' - Scratch pad config register invalid!", this->get_name().c_str());
@@ -295,7 +1860,9 @@ float DallasTemperatureSensor::get_temp_c() {
 
   return temp / 128.0f;
 }
-std::string DallasTemperatureSensor::unique_id() { return "dallas-" + str_lower_case(format_hex(this->address_)); }
+std::string DallasTemperatureSensor::unique_id() {
+  return "dallas-" + str_lower_case(format_hex(this->shown_address_()));
+}
 
 
 }  // namespace dallas
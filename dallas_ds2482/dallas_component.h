@@ -1,14 +1,169 @@
 #pragma once
 
+#include <atomic>
 #include "esphome/core/component.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esp_one_wire_800.h"
 #include "ds2482_defs.h"
+#include "device_table.h"
+
+#ifdef DALLAS_DS2482_WORKER
+#include "spsc_ring.h"
+#endif
 
 namespace esphome {
 namespace dallas {
 
 class DallasTemperatureSensor;
+class DallasComponent;
+
+static const uint8_t NO_CHANNEL = 0xFF;
+
+/// A converted channel whose scratch pads can be read from `due` (millis()) on.
+struct PendingRead {
+  uint32_t due;
+  uint8_t channel;
+  /// Check with a read slot whether the conversion is done instead of reading right away.
+  bool poll;
+};
+
+/// Phases of one non-blocking conversion/read sweep driven from loop().
+enum class SweepState : uint8_t {
+  IDLE,
+  CONVERT,
+  READ,
+  /// Alarm search on the channel being read, to poll sensors by exception.
+  ALARM,
+  /// Read slot on a converting channel, devices answer 1 once they are done.
+  POLL,
+  /// Background rescan of one channel after the reads.
+  SCAN,
+  /// Presence check of an inactive channel, scanned when something answers.
+  PROBE,
+  /// READ POWER SUPPLY on a channel whose devices changed.
+  POWER,
+  /// Setup of the sensors on a channel whose configuration is not known to be on the devices.
+  CONFIGURE,
+};
+
+/// Transactions of one sensor in the CONFIGURE phase.
+enum class ConfigStep : uint8_t {
+  READ,
+  WRITE,
+  /// Read back what was written, only a verified scratch pad goes to EEPROM.
+  VERIFY,
+  COPY,
+  /// Read slots until the EEPROM write of an externally powered device is done.
+  WAIT,
+};
+
+/// Hub values that can be published as diagnostic sensors. The counters, up to
+/// DIAGNOSTIC_SWEEP_DURATION, publish their increase since the last hub sweep.
+enum DiagnosticSensor : uint8_t {
+  DIAGNOSTIC_I2C_TRANSACTIONS,
+  DIAGNOSTIC_BUSY_POLLS,
+  DIAGNOSTIC_BUSY_TIMEOUTS,
+  DIAGNOSTIC_CRC_ERRORS,
+  DIAGNOSTIC_PRESENCE_ERRORS,
+  DIAGNOSTIC_SHORT_CIRCUITS,
+  DIAGNOSTIC_SWEEP_DURATION,
+  /// Sensors read per second by all hubs on the same I2C bus.
+  DIAGNOSTIC_BUS_THROUGHPUT,
+  DIAGNOSTIC_COUNT,
+};
+
+#ifdef DALLAS_DS2482_WORKER
+/// A value for the main loop to publish, handed over by the worker task.
+struct HandOff {
+  sensor::Sensor *sensor;
+  float value;
+};
+/// Readings and diagnostics in flight between the worker and the main loop.
+static const uint16_t DALLAS_WORKER_RING_SIZE = 64;
+
+/// The worker paces itself, the main loop keeps its regular cadence.
+struct NoLoopRequester {
+  void start() {}
+  void stop() {}
+};
+using BusLoopRequester = NoLoopRequester;
+#else
+using BusLoopRequester = HighFrequencyLoopRequester;
+#endif
+
+/// What the main loop shows of a hub. dump_config() reads a copy instead of the
+/// live state, which a worker task changes at any time; the sensors' addresses and
+/// channels are copied too, for their names.
+struct HubView {
+  DeviceTable devices;
+  uint8_t active_channels{0};
+  uint8_t parasite_channels{0};
+  uint32_t channel_selects_saved{0};
+  uint32_t resumes_used{0};
+  /// Per sensor, in registration order.
+  std::vector<uint64_t> sensor_address;
+  std::vector<uint8_t> sensor_channel;
+};
+
+/// Log2 histogram of durations in µs, for percentiles without storing samples.
+struct DurationHistogram {
+  static const uint8_t BUCKETS = 20;
+  uint16_t counts[BUCKETS]{};
+  uint16_t total{0};
+  uint32_t max{0};
+
+  void add(uint32_t us);
+  /// Upper bound of the bucket holding the given percentile.
+  uint32_t percentile(uint8_t percent) const;
+  void clear();
+};
+
+/// The hubs on one I2C bus. The first hub's loop() steps all of them, round robin
+/// and converting hubs first, so one hub's transfers fill another's 1-Wire waits.
+///
+/// Built with DALLAS_DS2482_WORKER, a task of its own steps the group instead and
+/// hands the values to publish over to the first hub's loop() through a ring.
+class DallasBusGroup {
+ public:
+  /// Add a hub to the group of its bus, creating the group on first use.
+  static DallasBusGroup *join(i2c::I2CBus *bus, DallasComponent *hub);
+
+  bool is_leader(const DallasComponent *hub) const { return this->hubs_.front() == hub; }
+  /// One loop() slice: step the hubs until none has I2C work or the time budget is used, true if any had.
+  bool loop();
+  void count_read() { this->reads_++; }
+  /// Sensors read per second over the last completed window.
+  float throughput();
+  uint8_t size() const { return this->hubs_.size(); }
+#ifdef DALLAS_DS2482_WORKER
+  /// Start the worker task, once all hubs have joined.
+  void start_worker();
+  bool worker_running() const { return this->worker_running_; }
+  /// Worker side: queue a value for the main loop.
+  void publish(sensor::Sensor *sensor, float value);
+  /// Main loop side: publish what the worker handed over.
+  void drain();
+  uint32_t dropped() const { return this->dropped_.load(std::memory_order_relaxed); }
+#endif
+
+ protected:
+#ifdef DALLAS_DS2482_WORKER
+  static void worker_task_(void *arg);
+
+  bool worker_running_{false};
+  SpscRing<HandOff, DALLAS_WORKER_RING_SIZE> ring_;
+  /// Values lost to a full ring, the main loop fell too far behind.
+  std::atomic<uint32_t> dropped_{0};
+#endif
+  i2c::I2CBus *bus_;
+  std::vector<DallasComponent *> hubs_;
+  /// Hub the next round starts with.
+  uint8_t next_{0};
+  uint32_t reads_{0};
+  uint32_t window_start_{0};
+  float last_rate_{0};
+};
 
 //class DallasComponent : public PollingComponent , public i2c::I2CDevice{
 class DallasComponent : public PollingComponent, public ESPOneWire800{
@@ -23,20 +178,281 @@ class DallasComponent : public PollingComponent, public ESPOneWire800{
   float get_setup_priority() const override { return setup_priority::DATA; }
 
   void update() override;
+  void loop() override;
+  /// Log the bus trace, from the worker task when it owns the bus.
+  void dump_trace();
+
+  /// Rescan one channel per update for added or removed devices.
+  void set_rescan(bool rescan) { this->rescan_ = rescan; }
+  void set_diagnostic_sensor(DiagnosticSensor type, sensor::Sensor *sensor) { this->diagnostic_sensors_[type] = sensor; }
+  /// Presence, short and CRC errors on one channel since the last hub sweep.
+  void set_channel_error_sensor(uint8_t channel, sensor::Sensor *sensor) { this->channel_error_sensors_[channel] = sensor; }
+  /// Keep the device table in flash and boot from it instead of searching.
+  void set_persist_devices(bool persist_devices) { this->persist_devices_ = persist_devices; }
+  /// Tells the device tables of hubs apart in flash, the hub's id: hubs on different buses share addresses.
+  void set_persist_key(const std::string &key);
+  /// Poll externally powered channels for the end of a conversion this often, 0 to wait the worst case.
+  void set_conversion_poll_interval(uint16_t interval) { this->conversion_poll_interval_ = interval; }
+  /// How often an inactive channel is checked for new devices, 0 to never check.
+  void set_probe_interval(uint32_t probe_interval) { this->probe_interval_ = probe_interval; }
+  /// Convert each channel again as soon as it is read and publish from the latest readings on update().
+  void set_continuous(bool continuous) { this->continuous_ = continuous; }
+  /// Only read sensors with alarm thresholds when an ALARM SEARCH finds them, and on
+  /// every DALLAS_ALARM_FULL_READ-th sweep otherwise. They publish when read.
+  void set_alarm_search(bool alarm_search) { this->alarm_search_ = alarm_search; }
   //void setchannel (uint8_t channel) {return }
 
  protected:
   friend DallasTemperatureSensor;
+  friend DallasBusGroup;
+
+  /// Advance this hub by at most one transfer, true if it used the I2C bus or queued a transaction.
+  bool step_();
+  /// Mark the hub's sensors due and start a sweep, update() on the thread owning the bus.
+  void handle_update_();
+  /// Publish a value, through the worker ring when there is one.
+  void publish_(sensor::Sensor *sensor, float value);
+  /// Set or clear the component warning, from the main loop in any case.
+  void set_warning_(bool warning);
+
+  /// Begin a sweep over the sensors marked due.
+  void start_sweep_();
+  /// Mark the sensors with their own interval that are due, true if any is.
+  bool schedule_intervals_();
+  /// Pick broadcast or addressed conversion for a channel, false if nothing on it is due.
+  bool plan_conversion_(uint8_t channel);
+  /// Advance the CONVERT phase to the next channel with due sensors, or on to READ.
+  void next_convert_channel_();
+  /// Convert the due interval sensors on channels the running sweep is done with, true if any.
+  /// Running continuously, every channel the sweep is done with converts again.
+  bool join_intervals_();
+  /// Drop the sensors of a failed conversion from the sweep, from `begin` up to `end`.
+  void conversion_failed_(uint8_t begin, uint8_t end);
+  /// Blocking search of all channels into a fresh devices_.
+  void search_channels_();
+  /// Fill devices_ from flash, false if nothing usable is stored.
+  bool load_devices_();
+  void save_devices_();
+  /// Write a table to flash, in as many records as its devices need.
+  void store_devices_(const DeviceTable &table);
+  /// Preference of record `n` of the table, made on first use.
+  ESPPreferenceObject &record_pref_(uint16_t n);
+  /// Mark the sensors whose cached config tag matches as configured, false if a sensor has no cached device.
+  bool restore_configured_();
+  /// First read of a cached device: confirm it on a valid scratch pad, or mark the cache stale.
+  void verify_cached_(DallasTemperatureSensor *sensor, bool success);
+  /// Scan all channels after a stale cache, before the sweep ends.
+  void start_refresh_();
+  /// Ask the devices on a channel whether any of them runs on parasite power. Blocking, for setup().
+  void detect_power_supply_(uint8_t channel);
+  /// Begin the POWER phase on the first channel of power_channels_.
+  void start_power_check_();
+  void power_result_(bool success);
+  /// Convert a channel on the strong pullup from now on.
+  void set_parasite_(uint8_t channel);
+  bool channel_populated_(uint8_t channel) const;
+  bool is_parasite_(uint8_t channel) const { return this->parasite_channels_ & (1 << channel); }
+  /// Check the CRC and family code of a found ROM.
+  bool valid_address_(uint64_t address);
+  /// Point an index sensor at its entry in devices_, false if there is none.
+  bool bind_index_sensor_(DallasTemperatureSensor *sensor);
+  /// Queue a search pass, `probe` not counting a missing presence pulse as an error.
+  void queue_search_(uint8_t channel, uint8_t command, bool probe = false);
+  /// Target the next temperature family in the running rescan, false when all are done.
+  bool next_scan_family_();
+  bool needs_read_(DallasTemperatureSensor *sensor);
+  /// Begin an alarm search on the channel just opened, false if it has nothing to search for.
+  bool start_alarm_search_();
+  void alarm_result_(bool success);
+  /// Rescan an active or probe an inactive channel after a hub sweep, false if neither is due.
+  bool start_background_scan_();
+  void start_scan_(uint8_t channel);
+  /// Channels with sensors or found devices.
+  void update_active_channels_();
+  /// First channel in `mask` after `after`, wrapping around.
+  uint8_t next_channel_(uint8_t mask, uint8_t after) const;
+  void scan_result_(bool success);
+  /// Apply the scan of scan_channel_ to devices_ and end the sweep.
+  void finish_scan_(bool complete);
+  void rebind_sensors_();
+  /// Bring the scratch pads of a channel's sensors in line with their config, EEPROM only where it changed.
+  /// Blocking, for setup(); sweeps use start_configure_() instead.
+  bool configure_channel_(uint8_t channel);
+  /// Remember that a sensor's resolution and alarms are on its device.
+  void mark_configured_(DallasTemperatureSensor *sensor);
+  /// Begin the CONFIGURE phase of a channel.
+  void start_configure_(uint8_t channel);
+  /// Queue the next transaction of the CONFIGURE phase.
+  void next_configure_transaction_();
+  void configure_result_(bool success);
+  /// Move the CONFIGURE phase on to the next sensor of its channel.
+  void next_configure_sensor_();
+  /// Group the sensors by channel for the read phase of a sweep.
+  void build_read_order_();
+  /// Insert a converted channel into read_queue_, ordered by due time.
+  void push_read_(uint8_t channel, uint32_t due, bool poll = false);
+  /// Take the first entry off read_queue_ if its window is open, false otherwise.
+  bool pop_due_read_(PendingRead &read);
+  /// Queue the conversion read of a channel just converted: a poll or its worst case deadline.
+  void schedule_read_(uint8_t channel);
+  void poll_result_(bool success);
+  /// Queue the next 1-Wire transaction of the running sweep, if it is due.
+  void next_transaction_();
+  /// Handle the end of the transaction queued by next_transaction_().
+  void transaction_done_(bool success);
+  /// Validate and publish the scratch pad the sensor just read.
+  void process_reading_(DallasTemperatureSensor *sensor, bool success);
+  /// Keep a new reading as the sensor's latest, publish it unless running continuously.
+  void deliver_(DallasTemperatureSensor *sensor, float value);
+  /// Publish the latest reading of the sensors marked due, continuous mode only.
+  void publish_latest_();
+  void end_sweep_();
+  /// One loop() slice of the running sweep.
+  void sweep_step_();
+  void log_sweep_stats_();
+  void publish_diagnostics_(uint32_t sweep_duration);
+
+  SweepState sweep_state_{SweepState::IDLE};
+  /// Channel the CONVERT phase is working on, out of convert_channels_.
+  uint8_t sweep_index_{0};
+  uint8_t convert_channels_{0};
+  /// Channels whose conversion failed in this sweep, not converted again before the next.
+  uint8_t convert_failed_{0};
+  /// Interval sensors are due whose channel was still busy at the last join_intervals_().
+  bool join_pending_{false};
+  /// Convert the sensors of sweep_index_ one by one with MATCH ROM instead of SKIP ROM.
+  bool convert_addressed_{false};
+  /// Position in read_order_ of the next addressed conversion.
+  uint8_t convert_pos_{0};
+  /// update() fired, the next sweep includes the sensors following the hub interval.
+  bool update_pending_{false};
+  /// The running sweep was started by update(): it rescans and publishes diagnostics.
+  bool hub_sweep_{false};
+  /// Some sensor has its own interval, next_interval_due_ is when the first one is due.
+  bool interval_sensors_{false};
+  uint32_t next_interval_due_{0};
+  /// Channels running on parasite power, they hold the bus for the whole conversion.
+  uint8_t parasite_channels_{0};
+  /// Strong pullup time of a broadcast conversion, set by plan_conversion_().
+  uint16_t convert_hold_{0};
+  /// A parasite channel is converting on the strong pullup until pullup_until_ (millis()).
+  bool pullup_active_{false};
+  uint32_t pullup_until_{0};
+  /// The queued transaction ends the strong pullup and belongs to no sweep state.
+  bool pullup_release_{false};
+  /// Channels with a running conversion whose sensors have not been read yet, earliest first.
+  PendingRead read_queue_[DS2482_MAX_CHANNELS];
+  uint8_t read_queue_len_{0};
+  /// Channel whose read window is open during READ.
+  uint8_t read_channel_{NO_CHANNEL};
+  /// Position in read_order_ of the sensor being read.
+  uint8_t read_pos_{0};
+  bool rescan_{false};
+  bool alarm_search_{false};
+  bool continuous_{false};
+  uint8_t scan_family_{0};
+  /// Channel the running scan walks.
+  uint8_t scan_channel_{0};
+  /// Channels with sensors or devices, the others are only probed every probe_interval_.
+  uint8_t active_channels_{0};
+  /// Channel the last rescan walked.
+  uint8_t rescan_channel_{0};
+  uint8_t probe_channel_{0};
+  uint32_t probe_interval_{0};
+  uint32_t last_probe_{0};
+  uint8_t scan_found_{0};
+  bool scan_changed_{false};
+  uint64_t scan_address_{0};
+  BusLoopRequester high_freq_;
+  DallasBusGroup *group_{nullptr};
+#ifdef DALLAS_DS2482_WORKER
+  // Main loop requests for the worker and back; the table is copied for the
+  // main loop to save, the worker leaves the copy alone while save_pending_
+  std::atomic<bool> update_request_{false};
+  std::atomic<bool> trace_request_{false};
+  std::atomic<uint8_t> warning_request_{0};
+  std::atomic<bool> save_pending_{false};
+  DeviceTable save_copy_;
+  /// The same for the view, the worker copies a new one once the main loop took the last.
+  std::atomic<bool> view_pending_{false};
+  HubView view_copy_;
+  /// Apply the requests of the worker, main loop side.
+  void apply_worker_requests_();
+  /// Hand a fresh view to the main loop, worker side.
+  void publish_view_();
+  /// Take the view over, main loop side.
+  void show_view_(const HubView &view);
+#endif
+  /// Copy the state dump_config() shows, on the thread stepping the hub.
+  void fill_view_(HubView &view) const;
+  HubView view_;
+
+  bool persist_devices_{false};
+  /// Hash of the persist key, 0 for none.
+  uint32_t persist_key_{0};
+  std::vector<ESPPreferenceObject> prefs_;
+  /// devices_ differs from what is in flash.
+  bool table_dirty_{false};
+  /// Cached devices not confirmed by a read yet.
+  uint16_t unverified_{0};
+  /// A cached device did not answer, scan all channels at the end of this sweep.
+  bool cache_stale_{false};
+  /// Channels the refresh after a stale cache has yet to scan.
+  uint8_t refresh_channels_{0};
+  /// Channels whose devices changed, their power supply is checked at the end of this sweep.
+  uint8_t power_channels_{0};
+  uint8_t power_channel_{0};
+  uint8_t power_bit_{0};
+  /// Channels whose sensors lost their configuration, set up again at the end of this sweep.
+  uint8_t reconfigure_channels_{0};
+  /// Channel and position in read_order_ of the sensor being configured.
+  uint8_t config_channel_{0};
+  uint8_t config_pos_{0};
+  ConfigStep config_step_{ConfigStep::READ};
+  /// WRITE SCRATCH PAD with the configuration, config_len_ bytes.
+  uint8_t config_block_[4]{};
+  uint8_t config_len_{0};
+  uint8_t config_copies_{0};
+  /// millis() when the running EEPROM write started, and when to look at it next.
+  uint32_t copy_start_{0};
+  uint32_t copy_poll_{0};
+  uint8_t copy_bit_{0};
+
+  // Cost of the running sweep: bus counters at its start, sensors read and
+  // the main loop time spent per loop() slice
+  ds2482_bus_stats sweep_bus_start_{};
+  uint32_t sweep_start_{0};
+  uint16_t sweep_reads_{0};
+  DurationHistogram slice_time_;
+
+  sensor::Sensor *diagnostic_sensors_[DIAGNOSTIC_COUNT]{};
+  sensor::Sensor *channel_error_sensors_[DS2482_MAX_CHANNELS]{};
+  /// Counter values at the last hub sweep, the sensors get the increase since.
+  uint32_t counters_published_[DIAGNOSTIC_SWEEP_DURATION]{};
+  uint32_t channel_errors_published_[DS2482_MAX_CHANNELS]{};
 
   std::vector<DallasTemperatureSensor *> sensors_;
+  /// Sensors grouped by channel, channel N occupies [channel_offset_[N], channel_offset_[N + 1]).
+  std::vector<DallasTemperatureSensor *> read_order_;
+  uint8_t channel_offset_[DS2482_MAX_CHANNELS + 1]{};
+  /// Longest conversion time of the sensors converted on each channel this sweep.
+  uint16_t channel_wait_[DS2482_MAX_CHANNELS]{};
+  uint16_t conversion_poll_interval_{0};
+  /// millis() when the last conversion on each channel was started.
+  uint32_t convert_start_[DS2482_MAX_CHANNELS]{};
+  /// Conversion time measured by polling, per channel, 0 until known.
+  uint16_t conversion_learned_[DS2482_MAX_CHANNELS]{};
+  uint8_t poll_bit_{0};
 //  std::vector<uint64_t> found_sensors_;
-  std::vector<address_channel> found_sensors_channel_;
+  DeviceTable devices_;
 
 }; 
 
 /// Internal class that helps us create multiple sensors for one Dallas hub.
 class DallasTemperatureSensor : public sensor::Sensor {
  public:
+  friend DallasComponent;
+
   void set_parent(DallasComponent *parent) { parent_ = parent; }
   /// Helper to get a pointer to the address as uint8_t.
   uint8_t *get_address8();
@@ -47,6 +463,15 @@ class DallasTemperatureSensor : public sensor::Sensor {
   void set_channel(uint8_t channel);
   /// Set the 64-bit unsigned address for this sensor.
   void set_address(uint64_t address);
+  /// Address the bus work uses, changed by rescans. The main loop goes by get_address_name().
+  uint64_t get_address() const;
+  /// Alarm thresholds (TH/TL) written to the scratch pad, in whole °C.
+  void set_alarm_high(int8_t alarm_high);
+  void set_alarm_low(int8_t alarm_low);
+  bool has_alarm() const;
+  /// Set by the alarm searches, from the worker task when there is one.
+  bool is_alarm_tripped() const { return this->alarm_tripped_.load(std::memory_order_relaxed); }
+  void set_alarm_tripped(bool tripped) { this->alarm_tripped_.store(tripped, std::memory_order_relaxed); }
   /// Get the index of this sensor. (0 if using address.)
   optional<uint8_t> get_index() const;
   /// Set the index of this sensor. If using index, address will be set after setup.
@@ -57,24 +482,81 @@ class DallasTemperatureSensor : public sensor::Sensor {
   void set_resolution(uint8_t resolution);
   /// Get the number of milliseconds we have to wait for the conversion phase.
   uint16_t millis_to_wait_for_conversion() const;
+  /// Poll this sensor every `update_interval` ms instead of on every hub update (0).
+  void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+  uint32_t get_update_interval() const { return this->update_interval_; }
 
+  /// Read the scratch pad and write resolution and alarms only if they differ, false on failure.
   bool setup_sensor();
+  /// Start COPY SCRATCHPAD, the caller waits for the EEPROM write.
+  bool copy_scratch_pad();
+  /// Queue WRITE SCRATCH PAD with a block from config_block().
+  bool queue_write_scratch_pad(uint8_t *block, uint8_t len);
+  /// Queue COPY SCRATCHPAD, powered by the strong pullup if asked; the caller waits for the EEPROM write.
+  bool queue_copy_scratch_pad(bool strong_pullup);
   bool read_scratch_pad();
+  /// Queue a CONVERT T addressed to this sensor only, powered by the strong pullup if asked.
+  bool queue_conversion(bool strong_pullup);
+  /// Queue a non-blocking scratch pad read on the parent's transaction queue.
+  bool queue_read_scratch_pad();
 
   bool check_scratch_pad();
 
   float get_temp_c();
+  /// Last value read from the device, NAN after a failed read; valid once has_latest().
+  /// Written by the worker task when there is one.
+  float get_latest() const { return this->latest_.load(std::memory_order_relaxed); }
+  bool has_latest() const { return this->has_latest_.load(std::memory_order_acquire); }
 
   std::string unique_id() override;
 
  protected:
+  /// Encoded configuration register for resolution_.
+  uint8_t config_register_() const;
+  /// Hash of resolution and alarms, kept in the device table to skip setup at boot.
+  uint8_t config_tag_() const;
+  /// The scratch pad last read holds the configured resolution and alarms.
+  bool config_matches_() const;
+  /// Fill `block` with WRITE SCRATCH PAD and the wanted alarms and configuration from the
+  /// scratch pad last read, returns its length or 0 if the device holds them already.
+  uint8_t config_block_(uint8_t *block) const;
+  /// The scratch pad last read holds what `block` wrote.
+  bool config_written_(const uint8_t *block, uint8_t len) const;
+
   DallasComponent *parent_;
-  uint64_t address_;
-  uint8_t channel_;
+  uint64_t address_{0};
+  uint8_t channel_{0};
   optional<uint8_t> index_;
 
   uint8_t resolution_;
+  optional<int8_t> alarm_high_;
+  optional<int8_t> alarm_low_;
+  std::atomic<bool> alarm_tripped_{false};
+  /// Sweeps skipped since the last read, while not in alarm.
+  uint8_t alarm_skips_{0};
+  /// setup_sensor() changed the scratch pad, it still has to go to EEPROM.
+  bool needs_copy_{false};
+  /// Resolution and alarms are known to be on the device.
+  bool configured_{false};
+  uint32_t update_interval_{0};
+  /// millis() at which a sensor with its own interval is due next.
+  uint32_t next_due_{0};
+  /// Wanted in the next sweep, and taking part in the running one.
+  bool due_{false};
+  bool in_sweep_{false};
+  std::atomic<float> latest_{NAN};
+  std::atomic<bool> has_latest_{false};
+#ifdef DALLAS_DS2482_WORKER
+  /// Address and channel as of the last view the worker handed over, main loop only.
+  uint64_t view_address_{0};
+  uint8_t view_channel_{0};
+#endif
+  /// Address and channel the main loop shows.
+  uint64_t shown_address_() const;
+  uint8_t shown_channel_() const;
   std::string address_name_;
+  /// Address address_name_ was made for.
+  uint64_t named_address_{0};
   uint8_t scratch_pad_[9] = {
       0,
   };
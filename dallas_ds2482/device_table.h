@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include "esphome/core/defines.h"
+
+#ifndef DALLAS_DS2482_MAX_DEVICES
+#define DALLAS_DS2482_MAX_DEVICES 64
+#endif
+
+namespace esphome {
+namespace dallas {
+
+/// Per-device state bits in DeviceTable::state.
+enum DeviceState : uint8_t {
+  DEVICE_STATE_PRESENT = 1 << 0,
+  /// Found again by the running rescan of its channel.
+  DEVICE_STATE_SEEN = 1 << 1,
+  /// Runs on parasite power.
+  DEVICE_STATE_PARASITE = 1 << 2,
+  /// Loaded from flash and not confirmed on the bus since boot.
+  DEVICE_STATE_CACHED = 1 << 3,
+};
+
+/// Devices per flash record of a persisted DeviceTable.
+static const uint8_t DEVICE_RECORD_SIZE = 8;
+
+/// One slice of a DeviceTable as stored in flash, about 100 bytes.
+struct DeviceRecord {
+  uint64_t address[DEVICE_RECORD_SIZE];
+  uint8_t channel[DEVICE_RECORD_SIZE];
+  uint8_t state[DEVICE_RECORD_SIZE];
+  uint8_t config_tag[DEVICE_RECORD_SIZE];
+  /// Devices in the whole table, the same in every record.
+  uint16_t count;
+};
+
+/// Fixed-capacity table of the 1-Wire devices found on the hub's channels.
+///
+/// Stored as parallel arrays so a scan over one attribute (e.g. all channels) stays
+/// within one small array. The capacity is set at compile time with max_devices.
+/// It is persisted in records of DEVICE_RECORD_SIZE devices, only as many as hold
+/// devices: the whole table can be too big for the flash of an ESP8266.
+struct DeviceTable {
+  uint64_t address[DALLAS_DS2482_MAX_DEVICES];
+  uint8_t channel[DALLAS_DS2482_MAX_DEVICES];
+  uint8_t family[DALLAS_DS2482_MAX_DEVICES];
+  uint8_t state[DALLAS_DS2482_MAX_DEVICES];
+  /// Hash of the resolution and alarms the device was configured with, 0 if unknown.
+  uint8_t config_tag[DALLAS_DS2482_MAX_DEVICES];
+  uint16_t count{0};
+
+  static constexpr uint16_t capacity() { return DALLAS_DS2482_MAX_DEVICES; }
+  bool empty() const { return this->count == 0; }
+  bool full() const { return this->count >= capacity(); }
+  void clear() { this->count = 0; }
+
+  /// Records needed to persist `count` devices, at least one to store the count.
+  static uint16_t records(uint16_t count) {
+    return count == 0 ? 1 : (count + DEVICE_RECORD_SIZE - 1) / DEVICE_RECORD_SIZE;
+  }
+
+  /// Copy the devices of record `n` out, for saving.
+  void store_record(uint16_t n, DeviceRecord &record) const {
+    record = {};
+    record.count = this->count;
+    for (uint16_t i = n * DEVICE_RECORD_SIZE, j = 0; i < this->count && j < DEVICE_RECORD_SIZE; i++, j++) {
+      record.address[j] = this->address[i];
+      record.channel[j] = this->channel[i];
+      record.state[j] = this->state[i];
+      record.config_tag[j] = this->config_tag[i];
+    }
+  }
+
+  /// Take the devices of record `n` in, false if it doesn't fit the table.
+  bool load_record(uint16_t n, const DeviceRecord &record) {
+    if (record.count > capacity() || n >= records(record.count))
+      return false;
+    this->count = record.count;
+    for (uint16_t i = n * DEVICE_RECORD_SIZE, j = 0; i < this->count && j < DEVICE_RECORD_SIZE; i++, j++) {
+      this->address[i] = record.address[j];
+      this->channel[i] = record.channel[j];
+      this->family[i] = record.address[j] & 0xFF;
+      this->state[i] = record.state[j];
+      this->config_tag[i] = record.config_tag[j];
+    }
+    return true;
+  }
+
+  /// Append a device, returns its index or -1 if the table is full.
+  int16_t add(uint64_t address, uint8_t channel) {
+    if (this->full())
+      return -1;
+    uint16_t i = this->count++;
+    this->address[i] = address;
+    this->channel[i] = channel;
+    this->family[i] = address & 0xFF;
+    this->state[i] = DEVICE_STATE_PRESENT;
+    this->config_tag[i] = 0;
+    return i;
+  }
+
+  /// Remove entry i, later entries move up by one.
+  void remove(uint16_t i) {
+    for (this->count--; i < this->count; i++)
+      this->copy_(i, i + 1);
+  }
+
+  /// Restore the order a fresh search produces: by channel, then in ROM search order
+  /// (the 0 branch of the lowest differing bit first).
+  void sort() {
+    for (uint16_t i = 1; i < this->count; i++) {
+      uint16_t j = i;
+      while (j > 0 && before_(i, j - 1))
+        j--;
+      if (j == i)
+        continue;
+      uint64_t address = this->address[i];
+      uint8_t channel = this->channel[i];
+      uint8_t state = this->state[i];
+      uint8_t config_tag = this->config_tag[i];
+      for (uint16_t k = i; k > j; k--)
+        this->copy_(k, k - 1);
+      this->address[j] = address;
+      this->channel[j] = channel;
+      this->family[j] = address & 0xFF;
+      this->state[j] = state;
+      this->config_tag[j] = config_tag;
+    }
+  }
+
+  /// Index of the device with this address, -1 if unknown.
+  int16_t find(uint64_t address) const {
+    for (uint16_t i = 0; i < this->count; i++) {
+      if (this->address[i] == address)
+        return i;
+    }
+    return -1;
+  }
+
+ protected:
+  void copy_(uint16_t to, uint16_t from) {
+    this->address[to] = this->address[from];
+    this->channel[to] = this->channel[from];
+    this->family[to] = this->family[from];
+    this->state[to] = this->state[from];
+    this->config_tag[to] = this->config_tag[from];
+  }
+  bool before_(uint16_t a, uint16_t b) const {
+    if (this->channel[a] != this->channel[b])
+      return this->channel[a] < this->channel[b];
+    uint64_t diff = this->address[a] ^ this->address[b];
+    return (this->address[a] & diff & -diff) == 0;
+  }
+};
+
+}  // namespace dallas
+}  // namespace esphome
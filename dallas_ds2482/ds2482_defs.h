@@ -54,11 +54,6 @@ struct	ds2482_dev {
 	//int8_t com_rslt;
 };
 
-typedef struct{
-	uint64_t address;
-	uint8_t channel;
-}address_channel;
-
 typedef struct{
 	struct ds2482_dev *dev;
 }my_dev_t;
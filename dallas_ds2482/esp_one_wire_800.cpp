@@ -1,6 +1,4 @@
-//#include <Wire.h>
-#include "Arduino.h"
-
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 #include "esphome/core/helpers.h"
 #include "esp_one_wire_800.h"
@@ -11,37 +9,109 @@ namespace dallas {
 
 static const char *const TAG = "dallas.one_wire_ds2482";
 
+// Channel selection codes written to / read back from the DS2482-800
+static const uint8_t CHANNEL_SELECT_CODES[] = {0xf0, 0xe1, 0xd2, 0xc3, 0xb4, 0xa5, 0x96, 0x87};
+static const uint8_t CHANNEL_READ_CODES[] = {0xb8, 0xb1, 0xaa, 0xa3, 0x9c, 0x95, 0x8e, 0x87};
+
 ESPOneWire800::ESPOneWire800() {}
 
 bool HOT IRAM_ATTR ESPOneWire800::reset() {
- ESP_LOGCONFIG(TAG, "Reset");
  return (readI2CByte()) ? 0 : -1; // presence
 }
 
 void IRAM_ATTR ESPOneWire800::writeI2CByte(uint8_t data)
 {
+	busYield();
+	i2c_arbiter::BusGuard guard(arbiter);
+	uint32_t start = micros();
 	buffer_data[0] = data;
-	write(buffer_data, 1);
+	busStats.writes++;
+	busStats.bytes += 1;
+	if (write(buffer_data, 1) != i2c::ERROR_OK)
+		i2cError();
+	busAccount(start);
 }
 
 void IRAM_ATTR ESPOneWire800::writeI2CByte2(uint8_t data0, uint8_t data1)
 {
+	busYield();
+	i2c_arbiter::BusGuard guard(arbiter);
+	uint32_t start = micros();
 	buffer_data[0] = data0;
     buffer_data[1] = data1;
 
-	write(buffer_data, 2);
+	busStats.writes++;
+	busStats.bytes += 2;
+	if (write(buffer_data, 2) != i2c::ERROR_OK)
+		i2cError();
+	busAccount(start);
 }
 
 uint8_t IRAM_ATTR ESPOneWire800::readI2CByte()
 {
-	read(buffer_data,1);
+	busYield();
+	i2c_arbiter::BusGuard guard(arbiter);
+	uint32_t start = micros();
+	busStats.reads++;
+	busStats.bytes += 1;
+	i2c::ErrorCode err = read(buffer_data, 1);
+	busAccount(start);
+	if (err != i2c::ERROR_OK)
+	{
+		i2cError();
+		return 0xFF;
+	}
 	return buffer_data[0];
 }
 
+void ESPOneWire800::attachArbiter()
+{
+	arbiter = i2c_arbiter::I2CBusArbiter::get(bus_);
+	arbiterClient = arbiter->add_client("ds2482", address_);
+}
+
+// Every transfer is a point where urgent work of other devices can take the
+// bus, also in the middle of a blocking search or busy wait. Called before the
+// transfer takes the bus lock, the jobs take it themselves.
+void IRAM_ATTR ESPOneWire800::busYield()
+{
+#ifndef DALLAS_DS2482_WORKER
+	// A worker task can't run jobs owned by the main loop
+	if (arbiter != nullptr)
+		arbiter->service(i2c_arbiter::PRIORITY_URGENT);
+#endif
+}
+
+void IRAM_ATTR ESPOneWire800::busAccount(uint32_t start)
+{
+	if (arbiter != nullptr)
+		arbiter->account(arbiterClient, micros() - start);
+}
+
+// The DS2482 state is unknown after a failed transfer
+void ESPOneWire800::i2cError()
+{
+	mError = DS2482_ERROR_I2C;
+	invalidateCache();
+}
+
+void ESPOneWire800::invalidateCache()
+{
+	// A transfer may have been lost halfway through a ROM command
+	memset(resumeRom, 0, sizeof(resumeRom));
+	currentChannel = DS2482_CHANNEL_UNKNOWN;
+	configValid = false;
+	readPointer = 0;
+	statusIdle = false;
+}
+
 // Performs a global reset of device state machine logic. Terminates any ongoing 1-Wire communication.
 bool IRAM_ATTR ESPOneWire800::deviceReset()
 {
 	writeI2CByte(DS2482_COMMAND_RESET);
+	invalidateCache();
+	readPointer = DS2482_POINTER_STATUS;
+	overdrive = false;
 	return true;
 }
 
@@ -49,20 +119,40 @@ bool IRAM_ATTR ESPOneWire800::deviceReset()
 void IRAM_ATTR ESPOneWire800::setReadPointer(uint8_t readPointer)
 {
 	writeI2CByte2(DS2482_COMMAND_SRP, readPointer);
+	this->readPointer = readPointer;
 }
 
-// Read the status register
+// Read the status register. The pointer stays parked there after every 1-Wire
+// command, so repeated polls are a single byte read.
 uint8_t IRAM_ATTR ESPOneWire800::readStatus()
 {
-	setReadPointer(DS2482_POINTER_STATUS);
+	if (readPointer != DS2482_POINTER_STATUS)
+		setReadPointer(DS2482_POINTER_STATUS);
 	return readI2CByte();
 }
 
 // Read the data register
 uint8_t IRAM_ATTR ESPOneWire800::readData()
 {
-	setReadPointer(DS2482_POINTER_DATA);
-	return readI2CByte();
+	// Set read pointer and read back in one I2C transaction (repeated start),
+	// nothing else may take the bus in between
+	busYield();
+	i2c_arbiter::BusGuard guard(arbiter);
+	uint32_t start = micros();
+	buffer_data[0] = DS2482_COMMAND_SRP;
+	buffer_data[1] = DS2482_POINTER_DATA;
+	readPointer = DS2482_POINTER_DATA;
+
+	busStats.reads++;
+	busStats.bytes += 3;
+	bool ok = write(buffer_data, 2, false) == i2c::ERROR_OK && read(buffer_data, 1) == i2c::ERROR_OK;
+	busAccount(start);
+	if (!ok)
+	{
+		i2cError();
+		return 0xFF;
+	}
+	return buffer_data[0];
 }
 
 // Read the config register
@@ -72,15 +162,32 @@ uint8_t IRAM_ATTR ESPOneWire800::readConfig()
 	return readI2CByte();
 }
 
+// Config register from the shadow, read from the device only when unknown
+uint8_t IRAM_ATTR ESPOneWire800::getConfig()
+{
+	if (!configValid)
+	{
+		// i2cError() clears configValid again if the read fails
+		configValid = true;
+		configShadow = readConfig();
+	}
+	return configShadow;
+}
+
 void IRAM_ATTR ESPOneWire800::setStrongPullup()
 {
-	writeConfig(readConfig() | DS2482_CONFIG_SPU);
+	writeConfig(getConfig() | DS2482_CONFIG_SPU);
+	DS2482_TRACE(TRACE_PULLUP, 1);
 }
 
 void IRAM_ATTR ESPOneWire800::clearStrongPullup()
 {
 	//writeConfig(readConfig() & !DS2482_CONFIG_SPU);
-	writeConfig(readConfig() &~DS2482_CONFIG_SPU);
+	uint8_t config = getConfig();
+	if (configValid && !(config & DS2482_CONFIG_SPU))
+		return;
+	writeConfig(config &~DS2482_CONFIG_SPU);
+	DS2482_TRACE(TRACE_PULLUP, 0);
 }
 
 // Churn until the busy bit in the status register is clear
@@ -88,75 +195,174 @@ uint8_t IRAM_ATTR ESPOneWire800::waitOnBusy()
 {
 	uint8_t status;
 
+	// Already seen idle and no 1-Wire command since, polling again can't tell more
+	if (statusIdle)
+		return lastStatus;
+
+	if (timedMode)
+		waitTimed();
+
 	for(int i=1000; i>0; i--)
 	{
 		status = readStatus();
+		busStats.statusPolls++;
 		if (!(status & DS2482_STATUS_BUSY))
+		{
+			statusIdle = true;
+			lastStatus = status;
 			break;
+		}
 		delayMicroseconds(20);
+		busStats.busyWaitUs += 20;
 	}
 
 	// if we have reached this point and we are still busy, there is an error
 	if (status & DS2482_STATUS_BUSY)
+	{
 		mError = DS2482_ERROR_TIMEOUT;
+		busStats.timeouts++;
+		DS2482_TRACE(TRACE_TIMEOUT, status);
+	}
 
 	// Return the status so we don't need to explicitly do it again
 	return status;
 }
 
+// Remember when the 1-Wire command just issued is guaranteed to be finished
+void IRAM_ATTR ESPOneWire800::markBusy(uint16_t duration)
+{
+	readPointer = DS2482_POINTER_STATUS;
+	busyUntil = micros() + duration;
+	statusIdle = false;
+}
+
+bool IRAM_ATTR ESPOneWire800::busyElapsed()
+{
+	int32_t remaining = (int32_t)(busyUntil - micros());
+	// A stale timestamp (micros() wrapped) counts as elapsed
+	return remaining <= 0 || remaining > DS2482_TIME_RESET_STD;
+}
+
+void IRAM_ATTR ESPOneWire800::waitTimed()
+{
+	if (busyElapsed())
+		return;
+
+	uint32_t remaining = busyUntil - micros();
+	delayMicroseconds(remaining);
+	busStats.busyWaitUs += remaining;
+}
+
+// Wait until the DS2482 accepts the next command
+void IRAM_ATTR ESPOneWire800::waitReady()
+{
+	if (timedMode)
+		waitTimed();
+	else
+		waitOnBusy();
+}
+
+uint16_t ESPOneWire800::resetTime() const
+{
+	return overdrive ? DS2482_TIME_RESET_OVD : DS2482_TIME_RESET_STD;
+}
+
+uint16_t ESPOneWire800::slotTime() const
+{
+	return overdrive ? DS2482_TIME_SLOT_OVD : DS2482_TIME_SLOT_STD;
+}
+
 // Write to the config register
 void IRAM_ATTR ESPOneWire800::writeConfig(uint8_t config)
 {
-	waitOnBusy();
+	waitReady();
 
 //	// Write the 4 bits and the complement 4 bits
     writeI2CByte2(DS2482_COMMAND_WRITECONFIG, config | (~config)<<4);
+	readPointer = DS2482_POINTER_CONFIG;
+	overdrive = config & DS2482_CONFIG_1WS;
 
 	// This should return the config bits without the complement
 	if (readI2CByte() != config)
+	{
 		mError = DS2482_ERROR_CONFIG;
+		configValid = false;
+		return;
+	}
+	configShadow = config;
+	configValid = true;
 }
 
 // Generates a 1-Wire reset/presence-detect cycle (Figure 4) at the 1-Wire line. The state
 // of the 1-Wire line is sampled at tSI and tMSP and the result is reported to the host 
-// processor through the Status Register, bits PPD and SD.
-uint8_t IRAM_ATTR ESPOneWire800::wireReset()
+// processor through the Status Register, bits PPD and SD. A probe doesn't count a
+// missing presence pulse as an error.
+uint8_t IRAM_ATTR ESPOneWire800::wireReset(bool probe)
 {
-	waitOnBusy();
+	waitReady();
 	// Datasheet warns that reset with SPU set can exceed max ratings
 	clearStrongPullup();
 
-	waitOnBusy();
-
 	writeI2CByte(DS2482_COMMAND_RESETWIRE);
+	markBusy(resetTime());
 
 	uint8_t status = waitOnBusy();
+	DS2482_TRACE(TRACE_RESET, status);
+	romCommandNext = checkResetStatus(status, probe);
+	if (!romCommandNext)
+		forgetResume(resumeChannel());
+	return romCommandNext;
+}
+
+bool IRAM_ATTR ESPOneWire800::checkResetStatus(uint8_t status, bool probe)
+{
+	bool known = currentChannel < DS2482_MAX_CHANNELS;
 
 	if (status & DS2482_STATUS_SD)
 	{
 		mError = DS2482_ERROR_SHORT;
+		if (known)
+			channelStats[currentChannel].shorts++;
 	}
 
-	return (status & DS2482_STATUS_PPD) ? true : false;
+	if (!(status & DS2482_STATUS_PPD))
+	{
+		if (known && !probe)
+			channelStats[currentChannel].noPresence++;
+		return false;
+	}
+	return true;
 }
 
 // Writes a single data byte to the 1-Wire line.
 void IRAM_ATTR ESPOneWire800::wireWriteByte(uint8_t data, uint8_t power)
 {
-	waitOnBusy();
+	waitReady();
 	if (power)
 		setStrongPullup();
 
     writeI2CByte2(DS2482_COMMAND_WRITEBYTE,data);
+	markBusy(8 * slotTime());
+	DS2482_TRACE(TRACE_WRITE, data);
+
+	if (romCommandNext)
+	{
+		romCommandNext = false;
+		if (data != RESUME)
+			forgetResume(resumeChannel());
+	}
 }
 
 // Generates eight read-data time slots on the 1-Wire line and stores result in the Read Data Register.
 uint8_t IRAM_ATTR ESPOneWire800::wireReadByte()
 {
-	waitOnBusy();
+	waitReady();
 	writeI2CByte(DS2482_COMMAND_READBYTE);
-	waitOnBusy();
-	return readData();
+	markBusy(8 * slotTime());
+	waitReady();
+	uint8_t data = readData();
+	DS2482_TRACE(TRACE_READ, data);
+	return data;
 }
 
 // Generates a single 1-Wire time slot with a bit value “V” as specified by the bit byte at the 1-Wire line
@@ -165,11 +371,12 @@ uint8_t IRAM_ATTR ESPOneWire800::wireReadByte()
 // level at the 1-Wire line is tested at tMSR and SBR is updated.
 void IRAM_ATTR ESPOneWire800::wireWriteBit(uint8_t data, uint8_t power)
 {
-	waitOnBusy();
+	waitReady();
 	if (power)
 		setStrongPullup();
 	
     writeI2CByte2(DS2482_COMMAND_SINGLEBIT, data ? 0x80 : 0x00);	
+	markBusy(slotTime());
 }
 
 // As wireWriteBit
@@ -188,112 +395,529 @@ void IRAM_ATTR ESPOneWire800::wireSkip()
 
 void IRAM_ATTR ESPOneWire800::wireSelect(const uint8_t rom[8])
 {
-	wireWriteByte(WIRE_COMMAND_SELECT);
+	uint64_t address = 0;
+
 	for (int i=0;i<8;i++)
-		wireWriteByte(rom[i]);
+		address |= (uint64_t)rom[i] << (8*i);
+	wireSelect(address);
 }
 
+// MATCH ROM, or just RESUME if the device is still selected from the last access
 void IRAM_ATTR ESPOneWire800::wireSelect(const uint64_t rom)
 {
-	wireWriteByte(WIRE_COMMAND_SELECT);
+	uint8_t ch = resumeChannel();
+	if (ch < DS2482_MAX_CHANNELS && rom == resumeRom[ch])
+	{
+		wireWriteByte(RESUME);
+		resumesUsed++;
+		return;
+	}
+
+	uint8_t block[8];
 	for (int i=0;i<8;i++)
+		block[i] = (rom>>(8*i))&0xff;
+	wireWriteByte(WIRE_COMMAND_SELECT);
+	wireWriteBlock(block, 8);
+	rememberMatch(ch, rom);
+}
+
+// Families with the RESUME command: DS2408, DS2431, DS2413, DS28EA00, DS28EC20
+bool ESPOneWire800::canResume(uint64_t rom)
+{
+	switch (rom & 0xFF)
 	{
-		wireWriteByte(((rom>>(8*i))&0xff)); 
+		case 0x29:
+		case 0x2D:
+		case 0x3A:
+		case 0x42:
+		case 0x43:
+			return true;
+		default:
+			return false;
 	}
 }
 
+void ESPOneWire800::forgetResume(uint8_t ch)
+{
+	if (ch < DS2482_MAX_CHANNELS)
+		resumeRom[ch] = 0;
+}
+
+void ESPOneWire800::rememberMatch(uint8_t ch, uint64_t rom)
+{
+	if (ch < DS2482_MAX_CHANNELS)
+		resumeRom[ch] = canResume(rom) ? rom : 0;
+}
+
+// Write several bytes; strong pullup (if requested) follows the last byte only
+void IRAM_ATTR ESPOneWire800::wireWriteBlock(const uint8_t *data, uint8_t len, uint8_t power)
+{
+	for (uint8_t i=0;i<len;i++)
+		wireWriteByte(data[i], power && i == len - 1);
+}
+
+// Read several bytes. Waits between bytes are skipped once the DS2482 has been
+// seen idle, and every byte costs one command plus one combined data read.
+void IRAM_ATTR ESPOneWire800::wireReadBlock(uint8_t *data, uint8_t len)
+{
+	for (uint8_t i=0;i<len;i++)
+		data[i] = wireReadByte();
+}
+
+// Reset, MATCH ROM (or RESUME), function command and read of the reply in one sequence
+bool IRAM_ATTR ESPOneWire800::wireSelectAndRead(const uint64_t rom, uint8_t command, uint8_t *data, uint8_t len)
+{
+	if (!wireReset())
+		return false;
+
+	wireSelect(rom);
+	wireWriteByte(command);
+	wireReadBlock(data, len);
+	return true;
+}
+
 //  1-Wire reset seatch algorithm
 void IRAM_ATTR ESPOneWire800::wireResetSearch()
 {
 	searchLastDiscrepancy = 0;
 	searchLastDeviceFlag = 0;
+	searchAddress = 0;
+	searchFamily = 0;
+}
 
-	for (int i = 0; i < 8; i++)
-	{
-		searchAddress[i] = 0;
-	}
-
+// Set up a search that only enumerates devices of one family (AN187 "target
+// setup"). The search ends as soon as the family code no longer matches.
+void IRAM_ATTR ESPOneWire800::wireTargetSearch(uint8_t family)
+{
+	searchLastDiscrepancy = 64;
+	searchLastDeviceFlag = 0;
+	searchAddress = family;
+	searchFamily = family;
 }
 
 // Set the channel on the DS2482-800
 uint8_t IRAM_ATTR ESPOneWire800::setChannel(uint8_t ch){
-  uint8_t w[] = {0xf0, 0xe1, 0xd2, 0xc3, 0xb4, 0xa5, 0x96, 0x87};
-  uint8_t r[] = {0xb8, 0xb1, 0xaa, 0xa3, 0x9c, 0x95, 0x8e, 0x87};
-  waitOnBusy();
+  // The DS2482-100 has its one channel and no channel select command
+  if (!hasChannels()) {
+    currentChannel = 0;
+    return ch == 0;
+  }
+  if (ch == currentChannel) {
+    channelSelectsSaved++;
+    return 1;
+  }
+  waitReady();
     
-    writeI2CByte2(DS2482_COMMAND_CHANNELSEL,w[ch]);
-
-     ESP_LOGD(TAG, "Channel Set: %d", ch);
+    writeI2CByte2(DS2482_COMMAND_CHANNELSEL,CHANNEL_SELECT_CODES[ch]);
+    readPointer = DS2482_POINTER_CHANNEL;
 
-  waitOnBusy();
-  return readI2CByte() == r[ch];
+  bool ok = readI2CByte() == CHANNEL_READ_CODES[ch];
+  currentChannel = ok ? ch : DS2482_CHANNEL_UNKNOWN;
+  DS2482_TRACE(TRACE_CHANNEL, ch);
+  return ok;
 }
 
 // Perform a search of the 1-Wire bus
 uint8_t IRAM_ATTR ESPOneWire800::wireSearch(uint8_t *address)
 {
-	uint8_t direction;
-	int8_t last_zero=-1; //
+	uint64_t rom;
 
-	if (searchLastDeviceFlag)
+	if (!wireSearch(&rom))
 		return 0;
 
-	if (!wireReset())
+	for (uint8_t i=0; i<8; i++)
+		address[i] = (rom>>(8*i))&0xff;
+
+	return 1;
+}
+
+// Perform a search of the 1-Wire bus, the ROM is stored LSB (family code) first
+uint8_t IRAM_ATTR ESPOneWire800::wireSearch(uint64_t *address)
+{
+	if (searchLastDeviceFlag)
 		return 0;
 
-	waitOnBusy();
+	// Nothing on the channel is what a search finds out, not an error
+	if (!wireReset(true))
+		return 0;
 
 	wireWriteByte(WIRE_COMMAND_SEARCH);
 
+	searchLastZero = 0;
 	for(uint8_t i=0;i<64;i++)
 	{
-		int searchByte = i / 8; 
-		int searchBit = 1 << i % 8;
+		waitReady();
 
-		if (i < searchLastDiscrepancy)
-			direction = searchAddress[searchByte] & searchBit;
-		else
-			direction = i == searchLastDiscrepancy;
+	    writeI2CByte2(DS2482_COMMAND_TRIPLET, searchDirection(i) ? 0x80 : 0x00 );
+		markBusy(3 * slotTime());
 
-		waitOnBusy();
+		uint8_t status = waitOnBusy();
+		DS2482_TRACE(TRACE_TRIPLET, status);
+		if (!searchResult(i, status))
+			return 0;
+	}
 
-	    writeI2CByte2(DS2482_COMMAND_TRIPLET, direction ? 0x80 : 0x00 );
+	searchFinish();
+	*address = searchAddress;
 
-		uint8_t status = waitOnBusy();
+	return 1;
+}
+
+// Search direction for bit i when both ROM values are present. Discrepancies
+// are counted from 1 so that 0 means "none", as in Maxim's AN187.
+uint8_t ESPOneWire800::searchDirection(uint8_t i)
+{
+	if (i + 1 < searchLastDiscrepancy)
+		return (searchAddress >> i) & 1;
+	return i + 1 == searchLastDiscrepancy;
+}
+
+// Evaluate the triplet status of bit i. Returns false if no device answered.
+bool ESPOneWire800::searchResult(uint8_t i, uint8_t status)
+{
+	uint8_t id = status & DS2482_STATUS_SBR;
+	uint8_t comp_id = status & DS2482_STATUS_TSB;
+	uint8_t direction = status & DS2482_STATUS_DIR;
+
+	if (id && comp_id)
+		return false;
+
+	if (!id && !comp_id && !direction)
+		searchLastZero = i + 1;
+
+	if (direction)
+		searchAddress |= 1ULL << i;
+	else
+		searchAddress &= ~(1ULL << i);
+
+	// Targeted search: no device of the family is left once a family bit differs
+	if (searchFamily && i < 8 && ((searchAddress ^ searchFamily) >> i) & 1)
+	{
+		searchLastDeviceFlag = 1;
+		return false;
+	}
+	return true;
+}
+
+void ESPOneWire800::searchFinish()
+{
+	searchLastDiscrepancy = searchLastZero;
+
+	if (searchLastZero == 0)
+		searchLastDeviceFlag = 1;
+}
+
+// Append a step to the asynchronous transaction queue
+bool ESPOneWire800::asyncQueue(uint8_t op, uint8_t data, uint8_t *dest)
+{
+	uint8_t idx = asyncHead + asyncCount;
+
+	if (idx >= DS2482_ASYNC_QUEUE_SIZE)
+		return false;
+
+	// Track the RESUME state as queued, a failed transaction forgets it all
+	if (asyncCount == 0)
+	{
+		queueChannel = resumeChannel();
+		queueAfterReset = false;
+	}
+	if (op == ASYNC_OP_CHANNEL)
+		queueChannel = data;
+	else if (queueAfterReset && (op == ASYNC_OP_WRITE || op == ASYNC_OP_WRITE_BLOCK) &&
+		!(op == ASYNC_OP_WRITE && data == RESUME))
+		forgetResume(queueChannel);
+	queueAfterReset = op == ASYNC_OP_RESET;
+
+	asyncSteps[idx].op = op;
+	asyncSteps[idx].data = data;
+	asyncSteps[idx].dest = dest;
+	asyncCount++;
+	return true;
+}
+
+// Queue MATCH ROM followed by the 8 address bytes (LSB first, as stored in memory),
+// or RESUME when the device is still selected from the last access
+bool ESPOneWire800::asyncQueueSelect(const uint64_t *rom)
+{
+	uint8_t ch = queueChannel;
+	if (ch < DS2482_MAX_CHANNELS && *rom == resumeRom[ch])
+	{
+		resumesUsed++;
+		return asyncQueue(ASYNC_OP_WRITE, RESUME);
+	}
+
+	if (!asyncQueue(ASYNC_OP_WRITE, WIRE_COMMAND_SELECT) ||
+		!asyncQueue(ASYNC_OP_WRITE_BLOCK, 8, const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(rom))))
+		return false;
+	rememberMatch(ch, *rom);
+	return true;
+}
+
+// Drop all queued steps, e.g. after a failed transaction
+void ESPOneWire800::asyncAbort()
+{
+	// Queued steps may have been counted on as sent, the RESUME state can't be trusted
+	memset(resumeRom, 0, sizeof(resumeRom));
+	asyncCount = 0;
+	asyncHead = 0;
+	asyncPhase = ASYNC_PHASE_ISSUE;
+	asyncIndex = 0;
+}
+
+uint8_t ESPOneWire800::asyncNext()
+{
+	asyncHead++;
+	asyncCount--;
+	asyncPhase = ASYNC_PHASE_ISSUE;
+	asyncIndex = 0;
+
+	if (asyncCount)
+		return DS2482_ASYNC_PENDING;
+
+	asyncHead = 0;
+	return DS2482_ASYNC_DONE;
+}
+
+// Continue a block step with its next byte, or finish the step
+uint8_t ESPOneWire800::asyncNextByte()
+{
+	if (++asyncIndex < asyncSteps[asyncHead].data)
+	{
+		asyncPhase = ASYNC_PHASE_ISSUE;
+		return DS2482_ASYNC_PENDING;
+	}
+	return asyncNext();
+}
+
+uint8_t ESPOneWire800::asyncFail()
+{
+	// A channel select may have been half done or the bus is in trouble
+	DS2482_TRACE(TRACE_FAIL, asyncSteps[asyncHead].op);
+	currentChannel = DS2482_CHANNEL_UNKNOWN;
+	asyncAbort();
+	return DS2482_ASYNC_FAILED;
+}
+
+// Advance the queued transaction by one I2C transfer. Returns DS2482_ASYNC_PENDING
+// while steps are outstanding, DS2482_ASYNC_DONE or DS2482_ASYNC_FAILED once when
+// the transaction ends and DS2482_ASYNC_IDLE if nothing is queued.
+uint8_t IRAM_ATTR ESPOneWire800::asyncPoll()
+{
+	if (!asyncCount)
+		return DS2482_ASYNC_IDLE;
 
-		uint8_t id = status & DS2482_STATUS_SBR;
-		uint8_t comp_id = status & DS2482_STATUS_TSB;
-		direction = status & DS2482_STATUS_DIR;
+	async_step &step = asyncSteps[asyncHead];
+	uint8_t status, config;
 
-		if (id && comp_id)
+	switch (asyncPhase)
+	{
+	case ASYNC_PHASE_ISSUE:
+		asyncStart = millis();
+		switch (step.op)
 		{
-			return 0;
+		case ASYNC_OP_CHANNEL:
+			if (!hasChannels())
+			{
+				currentChannel = 0;
+				return asyncNext();
+			}
+			if (step.data == currentChannel)
+			{
+				channelSelectsSaved++;
+				return asyncNext();
+			}
+			writeI2CByte2(DS2482_COMMAND_CHANNELSEL, CHANNEL_SELECT_CODES[step.data]);
+			readPointer = DS2482_POINTER_CHANNEL;
+			asyncPhase = ASYNC_PHASE_VERIFY;
+			return DS2482_ASYNC_PENDING;
+		case ASYNC_OP_RESET:
+			writeI2CByte(DS2482_COMMAND_RESETWIRE);
+			markBusy(resetTime());
+			break;
+		case ASYNC_OP_WRITE:
+			writeI2CByte2(DS2482_COMMAND_WRITEBYTE, step.data);
+			markBusy(8 * slotTime());
+			DS2482_TRACE(TRACE_WRITE, step.data);
+			break;
+		case ASYNC_OP_WRITE_BLOCK:
+			writeI2CByte2(DS2482_COMMAND_WRITEBYTE, step.dest[asyncIndex]);
+			markBusy(8 * slotTime());
+			DS2482_TRACE(TRACE_WRITE, step.dest[asyncIndex]);
+			break;
+		case ASYNC_OP_READ:
+			writeI2CByte(DS2482_COMMAND_READBYTE);
+			markBusy(8 * slotTime());
+			break;
+		case ASYNC_OP_READ_BIT:
+			writeI2CByte2(DS2482_COMMAND_SINGLEBIT, 0x80);
+			markBusy(slotTime());
+			break;
+		case ASYNC_OP_SEARCH:
+			if (asyncIndex == 0)
+				searchLastZero = 0;
+			writeI2CByte2(DS2482_COMMAND_TRIPLET, searchDirection(asyncIndex) ? 0x80 : 0x00);
+			markBusy(3 * slotTime());
+			break;
+		case ASYNC_OP_PULLUP:
+			// The shadow holds what was last written. After a reset or a failed
+			// transfer it is unknown, read the register first, one transfer per poll.
+			if (!configValid)
+			{
+				setReadPointer(DS2482_POINTER_CONFIG);
+				asyncPhase = ASYNC_PHASE_CONFIG;
+				return DS2482_ASYNC_PENDING;
+			}
+			config = step.data ? configShadow | DS2482_CONFIG_SPU : configShadow & ~DS2482_CONFIG_SPU;
+			writeI2CByte2(DS2482_COMMAND_WRITECONFIG, config | (~config) << 4);
+			readPointer = DS2482_POINTER_CONFIG;
+			configShadow = config;
+			DS2482_TRACE(TRACE_PULLUP, step.data);
+			asyncPhase = ASYNC_PHASE_VERIFY;
+			return DS2482_ASYNC_PENDING;
+		default:
+			return asyncFail();
+		}
+		asyncPhase = ASYNC_PHASE_WAIT;
+		return DS2482_ASYNC_PENDING;
+
+	case ASYNC_PHASE_WAIT:
+		if (timedMode)
+		{
+			// Nothing to ask the DS2482 before the command is guaranteed done,
+			// and writes/reads don't need the status at all afterwards
+			if (!busyElapsed())
+				return DS2482_ASYNC_PENDING;
+			if (step.op == ASYNC_OP_WRITE)
+				return asyncNext();
+			if (step.op == ASYNC_OP_WRITE_BLOCK)
+				return asyncNextByte();
+			if (step.op == ASYNC_OP_READ)
+			{
+				asyncPhase = ASYNC_PHASE_FETCH;
+				return DS2482_ASYNC_PENDING;
+			}
+		}
+
+		// 1-Wire commands leave the read pointer on the status register
+		status = readStatus();
+		busStats.statusPolls++;
+		if (status & DS2482_STATUS_BUSY)
+		{
+			if (millis() - asyncStart > DS2482_ASYNC_TIMEOUT_MS)
+			{
+				mError = DS2482_ERROR_TIMEOUT;
+				busStats.timeouts++;
+				DS2482_TRACE(TRACE_TIMEOUT, status);
+				return asyncFail();
+			}
+			return DS2482_ASYNC_PENDING;
+		}
+		statusIdle = true;
+		lastStatus = status;
+
+		if (step.op == ASYNC_OP_RESET)
+		{
+			DS2482_TRACE(TRACE_RESET, status);
+			if (!checkResetStatus(status, step.data))
+				return asyncFail();
 		}
-		else
+		else if (step.op == ASYNC_OP_READ)
 		{
-			if (!id && !comp_id && !direction)
+			asyncPhase = ASYNC_PHASE_FETCH;
+			return DS2482_ASYNC_PENDING;
+		}
+		else if (step.op == ASYNC_OP_WRITE_BLOCK)
+		{
+			return asyncNextByte();
+		}
+		else if (step.op == ASYNC_OP_SEARCH)
+		{
+			DS2482_TRACE(TRACE_TRIPLET, status);
+			if (!searchResult(asyncIndex, status))
+				return asyncFail();
+			if (++asyncIndex < 64)
 			{
-				last_zero = i;
+				asyncPhase = ASYNC_PHASE_ISSUE;
+				return DS2482_ASYNC_PENDING;
 			}
+			searchFinish();
+			memcpy(step.dest, &searchAddress, sizeof(searchAddress));
 		}
+		else if (step.op == ASYNC_OP_READ_BIT)
+		{
+			*step.dest = (status & DS2482_STATUS_SBR) ? 1 : 0;
+			DS2482_TRACE(TRACE_READ, *step.dest);
+		}
+		return asyncNext();
 
-		if (direction)
-			searchAddress[searchByte] |= searchBit;
-		else
-			searchAddress[searchByte] &= ~searchBit;
+	case ASYNC_PHASE_FETCH:
+		step.dest[asyncIndex] = readData();
+		DS2482_TRACE(TRACE_READ, step.dest[asyncIndex]);
+		return asyncNextByte();
 
+	case ASYNC_PHASE_VERIFY:
+		if (step.op == ASYNC_OP_PULLUP)
+		{
+			if (readI2CByte() != configShadow)
+			{
+				mError = DS2482_ERROR_CONFIG;
+				configValid = false;
+				return asyncFail();
+			}
+			configValid = true;
+			return asyncNext();
+		}
+		if (readI2CByte() != CHANNEL_READ_CODES[step.data])
+			return asyncFail();
+		currentChannel = step.data;
+		DS2482_TRACE(TRACE_CHANNEL, step.data);
+		return asyncNext();
+
+	case ASYNC_PHASE_CONFIG:
+		// i2cError() clears configValid again if the read fails
+		configValid = true;
+		configShadow = readI2CByte();
+		if (!configValid)
+			return asyncFail();
+		asyncPhase = ASYNC_PHASE_ISSUE;
+		return DS2482_ASYNC_PENDING;
 	}
 
-	searchLastDiscrepancy = last_zero;
+	return asyncFail();
+}
 
-	if (last_zero == -1)
-		searchLastDeviceFlag = 1;
+#ifdef DALLAS_DS2482_TRACE
+void IRAM_ATTR ESPOneWire800::trace(uint8_t event, uint8_t data)
+{
+	trace_entry &entry = traceRing[traceNext];
+	entry.time = micros();
+	entry.event = event;
+	entry.channel = currentChannel;
+	entry.data = data;
+	traceNext = (traceNext + 1) % DALLAS_DS2482_TRACE;
+	if (traceCount < DALLAS_DS2482_TRACE)
+		traceCount++;
+}
 
-	for (uint8_t i=0; i<8; i++)
-		address[i] = searchAddress[i];
+void ESPOneWire800::dumpTrace()
+{
+	static const char *const NAMES[] = {"channel", "reset", "write", "read", "triplet", "pullup", "timeout", "fail"};
+	uint16_t first = (traceNext + DALLAS_DS2482_TRACE - traceCount) % DALLAS_DS2482_TRACE;
 
-	return 1;
+	ESP_LOGI(TAG, "Trace, %u events:", traceCount);
+	for (uint16_t n = 0; n < traceCount; n++)
+	{
+		const trace_entry &entry = traceRing[(first + n) % DALLAS_DS2482_TRACE];
+		ESP_LOGI(TAG, "  %10" PRIu32 " ch %u %-7s 0x%02X", entry.time, entry.channel, NAMES[entry.event], entry.data);
+	}
+	traceCount = 0;
+}
+#else
+void ESPOneWire800::dumpTrace()
+{
+	ESP_LOGW(TAG, "Trace not compiled in, set trace_size");
 }
+#endif
 
 #if ONEWIRE_CRC8_TABLE
 // This table comes from Dallas sample code where it is freely reusable,
@@ -328,7 +952,7 @@ uint8_t IRAM_ATTR ESPOneWire800::crc8(const uint8_t *addr, uint8_t len)
 	uint8_t crc = 0;
 
 	while (len--) {
-		crc = pgm_read_byte(dscrc_table + (crc ^ *addr++));
+		crc = progmem_read_byte(dscrc_table + (crc ^ *addr++));
 	}
 	return crc;
 }
@@ -354,47 +978,5 @@ uint8_t IRAM_ATTR ESPOneWire800::crc8(const uint8_t *addr, uint8_t len)
 }
 #endif
 
-std::vector<uint64_t> ESPOneWire800::search_vec() {
-  std::vector<uint64_t> res;
-
-  unsigned char romids[8];
-  uint64_t romid;
-  int idx = 0;
-
- 	  int ret = wireSearch(romids);
-  
-	    romid = (uint64_t)romids[7]<<56|(uint64_t)romids[6]<<48
-		      | (uint64_t)romids[5]<<40|(uint64_t)romids[4]<<32
-			  | (uint64_t)romids[3]<<24|(uint64_t)romids[2]<<16
-			  | (uint64_t)romids[1]<<8 |(uint64_t)romids[0]<<0;
- 	 
-	  if (ret==true) 
-	  {
-		res.push_back(romid);
-		ESP_LOGI(TAG, "New Sensor: %2x:%2x:%2x:%2x:%2x:%2x:%2x:%2x",  romids[7], romids[6], romids[5], romids[4], romids[3], romids[2], romids[1], romids[0]);
-	  }
-	  else
-        ESP_LOGCONFIG(TAG, "No Sensor found");
-
-
-	  while(ret){
-
-	    ret = wireSearch(romids);    
-	    romid = (uint64_t)romids[7]<<56|(uint64_t)romids[6]<<48
-		      | (uint64_t)romids[5]<<40|(uint64_t)romids[4]<<32
-			  | (uint64_t)romids[3]<<24|(uint64_t)romids[2]<<16
-			  | (uint64_t)romids[1]<<8 |(uint64_t)romids[0]<<0;
-
-	    if (ret==true) 
-		{
-			res.push_back(romid);
-		ESP_LOGI(TAG, "New Sensor: %2x:%2x:%2x:%2x:%2x:%2x:%2x:%2x",  romids[7], romids[6], romids[5], romids[4], romids[3], romids[2], romids[1], romids[0]);
-
-		}
-
-	  }
-  return res;
- }
-
   } // namespace esphome
 }   // namespace dallas
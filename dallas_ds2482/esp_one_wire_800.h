@@ -1,8 +1,9 @@
 #pragma once
 
 #include "esphome/core/hal.h"
+#include "esphome/core/defines.h"
 #include "esphome/components/i2c/i2c.h"
-#include <vector>
+#include "esphome/components/i2c_arbiter/i2c_arbiter.h"
 #include "ds2482_defs.h"
 
 #include <stddef.h>
@@ -26,6 +27,7 @@
 #define DS2482_STATUS_DIR 			(1<<7)
 #define DS2482_POINTER_DATA			0xE1
 #define DS2482_POINTER_CONFIG		0xC3
+#define DS2482_POINTER_CHANNEL		0xD2
 #define DS2482_CONFIG_APU			(1<<0)
 #define DS2482_CONFIG_SPU			(1<<2)
 #define DS2482_CONFIG_1WS			(1<<3)
@@ -44,9 +46,44 @@
 
 //#define DS2482_ADDRESS 0x18
 
+// Worst case duration of the DS2482 1-Wire state machine in µs (datasheet
+// reset and time slot durations plus oscillator tolerance)
+#define DS2482_TIME_RESET_STD		1270
+#define DS2482_TIME_RESET_OVD		160
+#define DS2482_TIME_SLOT_STD		80
+#define DS2482_TIME_SLOT_OVD		12
+
 #define DS2482_ERROR_TIMEOUT		(1<<0)
 #define DS2482_ERROR_SHORT			(1<<1)
 #define DS2482_ERROR_CONFIG			(1<<2)
+#define DS2482_ERROR_I2C			(1<<3)
+
+#define DS2482_CHANNEL_UNKNOWN		0xFF
+
+// Channels compiled in. Only DS2482-100s in the build (one channel) drop the
+// channel selection code altogether.
+#ifdef DALLAS_DS2482_CHANNELS
+#define DS2482_MAX_CHANNELS			DALLAS_DS2482_CHANNELS
+#else
+#define DS2482_MAX_CHANNELS			8
+#endif
+
+// Asynchronous transaction queue, driven by asyncPoll() from loop()
+#define DS2482_ASYNC_QUEUE_SIZE		16
+#define DS2482_ASYNC_TIMEOUT_MS		20
+
+// Binary trace of the 1-Wire traffic, DALLAS_DS2482_TRACE is the ring size.
+// Without it the trace points compile to nothing.
+#ifdef DALLAS_DS2482_TRACE
+#define DS2482_TRACE(event, data)	trace(event, data)
+#else
+#define DS2482_TRACE(event, data)
+#endif
+
+#define DS2482_ASYNC_IDLE			0
+#define DS2482_ASYNC_PENDING		1
+#define DS2482_ASYNC_DONE			2
+#define DS2482_ASYNC_FAILED			3
 
 namespace esphome {
 namespace dallas {
@@ -68,6 +105,67 @@ typedef enum {
     OVERDRIVE_MATCH = 0x69,
 } one_wire_rom_commands;
 
+typedef enum {
+    ASYNC_OP_CHANNEL, // select channel, data = channel
+    ASYNC_OP_RESET, // 1-Wire reset, fails without presence pulse (data = 1: probe, not counted as an error)
+    ASYNC_OP_WRITE, // write data byte
+    ASYNC_OP_WRITE_BLOCK, // write data bytes from dest
+    ASYNC_OP_READ, // read data bytes into dest
+    ASYNC_OP_SEARCH, // next ROM search pass (after reset + SEARCH ROM), 64-bit ROM into dest
+    ASYNC_OP_PULLUP, // data = 1 arms the strong pullup for the next write, 0 ends it
+    ASYNC_OP_READ_BIT, // read time slot, 0 or 1 into dest
+} async_op_type;
+
+typedef enum {
+    ASYNC_PHASE_ISSUE, // send the DS2482 command
+    ASYNC_PHASE_WAIT, // poll status until 1WB clears
+    ASYNC_PHASE_FETCH, // read the data register
+    ASYNC_PHASE_VERIFY, // read back the channel selection or config register
+    ASYNC_PHASE_CONFIG, // read the config register before changing it
+} async_phase;
+
+typedef struct {
+    uint8_t op;
+    uint8_t data;
+    uint8_t *dest;
+} async_step;
+
+// I2C traffic and busy waiting caused by the driver
+typedef struct {
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t bytes; // I2C payload bytes, without address bytes
+    uint32_t busyWaitUs; // time spent in delayMicroseconds() waiting for the DS2482
+    uint32_t statusPolls; // status reads while waiting for 1WB to clear
+    uint32_t timeouts; // waits given up with 1WB still set
+} ds2482_bus_stats;
+
+// Error counters of one DS2482-800 channel
+typedef struct {
+    uint32_t noPresence; // resets without presence pulse
+    uint32_t shorts; // resets reporting a short (SD)
+    uint32_t crcErrors; // scratch pads with a bad CRC
+} ds2482_channel_stats;
+
+// Events of the binary trace
+typedef enum {
+    TRACE_CHANNEL, // channel selected, data = channel
+    TRACE_RESET, // reset done, data = status
+    TRACE_WRITE, // byte written, data = byte
+    TRACE_READ, // byte read, data = byte
+    TRACE_TRIPLET, // search triplet done, data = status
+    TRACE_PULLUP, // strong pullup armed (1) or released (0)
+    TRACE_TIMEOUT, // gave up waiting for 1WB, data = status
+    TRACE_FAIL, // async transaction aborted, data = step op
+} trace_event;
+
+typedef struct {
+    uint32_t time; // micros()
+    uint8_t event;
+    uint8_t channel;
+    uint8_t data;
+} trace_entry;
+
 extern const uint8_t ONE_WIRE_ROM_SELECT;
 extern const int ONE_WIRE_ROM_SEARCH;
 
@@ -97,8 +195,20 @@ class ESPOneWire800 : public i2c::I2CDevice{
 	void writeConfig(uint8_t config);
 	void setStrongPullup();
         uint8_t setChannel(uint8_t ch);
+	// Forget the cached channel and config register, e.g. after a bus error
+	void invalidateCache();
+	uint32_t getChannelSelectsSaved() const { return channelSelectsSaved; }
+	// MATCH ROMs replaced by RESUME
+	uint32_t getResumesUsed() const { return resumesUsed; }
+	// 1 for a DS2482-100, 8 for a DS2482-800
+	void setChannelCount(uint8_t count) { channelCount = count; }
+	uint8_t getChannelCount() const { return channelCount; }
 	void clearStrongPullup();
-	uint8_t wireReset();
+	// Timed mode: wait the guaranteed 1-Wire duration instead of polling the
+	// status register before every command
+	void setTimedMode(bool timed) { timedMode = timed; }
+	bool getTimedMode() const { return timedMode; }
+	uint8_t wireReset(bool probe = false);
 	void wireWriteByte(uint8_t data, uint8_t power = 0);
 	uint8_t wireReadByte();
 	void wireWriteBit(uint8_t data, uint8_t power = 0);
@@ -106,14 +216,38 @@ class ESPOneWire800 : public i2c::I2CDevice{
 	void wireSkip();
 	void wireSelect(const uint8_t rom[8]);
         void wireSelect(const uint64_t rom);
+	void wireWriteBlock(const uint8_t *data, uint8_t len, uint8_t power = 0);
+	void wireReadBlock(uint8_t *data, uint8_t len);
+	bool wireSelectAndRead(const uint64_t rom, uint8_t command, uint8_t *data, uint8_t len);
 	
 	void wireResetSearch();
+	void wireTargetSearch(uint8_t family);
+	bool wireSearchDone() const { return searchLastDeviceFlag; }
 	uint8_t wireSearch(uint8_t *address);
+	uint8_t wireSearch(uint64_t *address);
 
 	static uint8_t crc8(const uint8_t *addr, uint8_t len);
 
-  /// Helper that wraps search in a std::vector.
-  std::vector<uint64_t> search_vec();
+	// Non-blocking transaction queue. Every asyncPoll() call performs at most
+	// one I2C transfer and never waits for the 1-Wire line.
+	bool asyncQueue(uint8_t op, uint8_t data = 0, uint8_t *dest = nullptr);
+	// rom must stay valid until the transaction has ended
+	bool asyncQueueSelect(const uint64_t *rom);
+	uint8_t asyncPoll();
+	void asyncAbort();
+	bool asyncActive() { return asyncCount != 0; }
+
+	const ds2482_bus_stats &getBusStats() const { return busStats; }
+	const ds2482_channel_stats &getChannelStats(uint8_t ch) const { return channelStats[ch]; }
+	// A garbled reply may mean the device lost its RESUME selection, e.g. after a
+	// power glitch, so the next access to the channel matches the ROM again
+	void recordCrcError(uint8_t ch) { channelStats[ch].crcErrors++; forgetResume(ch); }
+	// Log the trace ring, oldest event first
+	void dumpTrace();
+	// Share the I2C bus: account our transfers and let urgent work of other
+	// devices run between them
+	void attachArbiter();
+	i2c_arbiter::I2CBusArbiter *getArbiter() const { return arbiter; }
 
  protected:
 	void writeI2CByte(uint8_t);   // remapped
@@ -121,11 +255,95 @@ class ESPOneWire800 : public i2c::I2CDevice{
 	uint8_t readI2CByte();	// remapped
 
 	uint8_t mError;
+	ds2482_bus_stats busStats{};
+	ds2482_channel_stats channelStats[DS2482_MAX_CHANNELS]{};
+
+	// Evaluate PPD/SD after a 1-Wire reset, returns whether a device answered
+	bool checkResetStatus(uint8_t status, bool probe = false);
     uint8_t buffer_data[2];
     uint8_t buffer_len;
-	uint8_t searchAddress[8];
+	uint64_t searchAddress;
 	uint8_t searchLastDiscrepancy;
 	uint8_t searchLastDeviceFlag;
+	uint8_t searchLastZero;
+	// Family code of a targeted search, 0 for a full search
+	uint8_t searchFamily{0};
+
+	uint8_t searchDirection(uint8_t i);
+	bool searchResult(uint8_t i, uint8_t status);
+	void searchFinish();
+
+	void markBusy(uint16_t duration);
+	bool busyElapsed();
+	void waitTimed();
+	void waitReady();
+	uint16_t resetTime() const;
+	uint16_t slotTime() const;
+
+	void i2cError();
+	uint8_t getConfig();
+	void busYield();
+	void busAccount(uint32_t start);
+
+	i2c_arbiter::I2CBusArbiter *arbiter{nullptr};
+	uint8_t arbiterClient{0};
+
+	// Shadow of the selected channel and the config register
+	uint8_t currentChannel{DS2482_CHANNEL_UNKNOWN};
+	uint8_t configShadow{0};
+	bool configValid{false};
+	uint32_t channelSelectsSaved{0};
+	uint8_t channelCount{DS2482_MAX_CHANNELS};
+
+	// RESUME: the device last selected with MATCH ROM on each channel, 0 if none
+	// or if it can't resume. Any other ROM command on the channel ends it.
+	static bool canResume(uint64_t rom);
+	uint8_t resumeChannel() const { return hasChannels() ? currentChannel : 0; }
+	void forgetResume(uint8_t ch);
+	void rememberMatch(uint8_t ch, uint64_t rom);
+	uint64_t resumeRom[DS2482_MAX_CHANNELS]{};
+	uint32_t resumesUsed{0};
+	// The next byte written after a reset is a ROM command
+	bool romCommandNext{false};
+	// Channel and ROM command position of the transaction being queued
+	uint8_t queueChannel{DS2482_CHANNEL_UNKNOWN};
+	bool queueAfterReset{false};
+#ifdef DALLAS_DS2482_TRACE
+	void trace(uint8_t event, uint8_t data);
+	trace_entry traceRing[DALLAS_DS2482_TRACE];
+	uint16_t traceNext{0};
+	uint16_t traceCount{0};
+#endif
+	bool hasChannels() const
+	{
+#if DS2482_MAX_CHANNELS > 1
+		return channelCount > 1;
+#else
+		return false;
+#endif
+	}
+
+	// Status seen with 1WB clear and no 1-Wire command issued since
+	bool statusIdle{false};
+	uint8_t lastStatus{0};
+
+	// Register the DS2482 read pointer currently points to
+	uint8_t readPointer{0};
+	bool timedMode{false};
+	bool overdrive{false};
+	// micros() timestamp at which the last 1-Wire command is guaranteed done
+	uint32_t busyUntil{0};
+
+	uint8_t asyncNext();
+	uint8_t asyncNextByte();
+	uint8_t asyncFail();
+
+	async_step asyncSteps[DS2482_ASYNC_QUEUE_SIZE];
+	uint8_t asyncCount{0};
+	uint8_t asyncHead{0};
+	uint8_t asyncPhase{ASYNC_PHASE_ISSUE};
+	uint8_t asyncIndex{0};
+	uint32_t asyncStart{0};
 
 
   /// Helper to get the internal 64-bit unsigned rom number as a 8-bit integer pointer.
@@ -7,6 +7,7 @@ from esphome.const import (
     CONF_DALLAS_ID,
     CONF_INDEX,
     CONF_RESOLUTION,
+    CONF_UPDATE_INTERVAL,
     DEVICE_CLASS_TEMPERATURE,
     STATE_CLASS_MEASUREMENT,
     UNIT_CELSIUS,
@@ -15,6 +16,9 @@ from . import DallasComponent, dallas_ns
 
 DallasTemperatureSensor = dallas_ns.class_("DallasTemperatureSensor", sensor.Sensor)
 
+CONF_ALARM_HIGH = "alarm_high"
+CONF_ALARM_LOW = "alarm_low"
+
 CONFIG_SCHEMA = cv.All(
     sensor.sensor_schema(
         DallasTemperatureSensor,
@@ -29,6 +33,10 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_CHANNEL): cv.int_range(min=0, max=7),     
             cv.Optional(CONF_INDEX): cv.positive_int,
             cv.Optional(CONF_RESOLUTION, default=12): cv.int_range(min=9, max=12),
+            cv.Optional(CONF_ALARM_HIGH): cv.int_range(min=-55, max=125),
+            cv.Optional(CONF_ALARM_LOW): cv.int_range(min=-55, max=125),
+            # Poll on its own cadence instead of on every hub update
+            cv.Optional(CONF_UPDATE_INTERVAL): cv.positive_time_period_milliseconds,
         }
     ),
     cv.has_exactly_one_key(CONF_ADDRESS, CONF_INDEX),
@@ -50,6 +58,14 @@ async def to_code(config):
     if CONF_RESOLUTION in config:
         cg.add(var.set_resolution(config[CONF_RESOLUTION]))
 
+    if CONF_ALARM_HIGH in config:
+        cg.add(var.set_alarm_high(config[CONF_ALARM_HIGH]))
+    if CONF_ALARM_LOW in config:
+        cg.add(var.set_alarm_low(config[CONF_ALARM_LOW]))
+
+    if CONF_UPDATE_INTERVAL in config:
+        cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
+
     cg.add(var.set_parent(hub))
 
     cg.add(hub.register_sensor(var))
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace esphome {
+namespace dallas {
+
+/// Lock-free ring for exactly one producer and one consumer thread.
+///
+/// Each index is only written by its own side, so one acquire/release pair per
+/// access is all the synchronisation needed. SIZE must be a power of two; one
+/// slot stays empty to tell a full ring from an empty one.
+template<typename T, uint16_t SIZE> class SpscRing {
+  static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "SpscRing size must be a power of two");
+
+ public:
+  /// Producer side, false if the ring is full.
+  bool push(const T &item) {
+    uint16_t head = this->head_.load(std::memory_order_relaxed);
+    uint16_t next = (head + 1) & (SIZE - 1);
+    if (next == this->tail_.load(std::memory_order_acquire))
+      return false;
+    this->items_[head] = item;
+    this->head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer side, false if the ring is empty.
+  bool pop(T &item) {
+    uint16_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->head_.load(std::memory_order_acquire))
+      return false;
+    item = this->items_[tail];
+    this->tail_.store((tail + 1) & (SIZE - 1), std::memory_order_release);
+    return true;
+  }
+
+ protected:
+  T items_[SIZE];
+  std::atomic<uint16_t> head_{0};
+  std::atomic<uint16_t> tail_{0};
+};
+
+}  // namespace dallas
+}  // namespace esphome
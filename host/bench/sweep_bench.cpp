@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "esphome/core/hal.h"
+#include "esphome/host/clock.h"
+#include "esphome/host/log.h"
+#include "esphome/host/preferences.h"
+#include "ds2482.h"
+#include "harness.h"
+
+// Cost of the hub on the simulated DS2482-800, for N sensors spread over its 8
+// channels: the setup() search and configuration, a blocking read_scratch_pad()
+// and the sweeps started by update(). Reports I2C transactions and bytes per
+// sensor, the latency of a sweep and how long single calls block the main loop.
+// Times are on the simulated clock, so they only move when the driver changes.
+// Transactions (xfers) and bytes are per sensor, the scratch pad columns are one
+// blocking read_scratch_pad() and its p50 duration.
+//
+//   host_bench [sweeps]
+
+namespace esphome {
+namespace sim {
+
+using dallas::DallasComponent;
+using dallas::DallasTemperatureSensor;
+
+static const uint8_t CHANNELS = 8;
+static const uint8_t HUB_ADDRESS = 0x18;
+static const uint32_t SWEEP_TIMEOUT_MS = 10000;
+/// Loop iterations between sweeps, where the hub finishes anything a sweep started.
+static const uint32_t SWEEP_GAP_MS = 200;
+
+struct Scenario {
+  uint8_t sensors;
+  uint8_t resolution;
+  bool parasite;
+};
+
+struct Counters {
+  uint32_t transfers;
+  uint32_t bytes;
+
+  static Counters of(const SimBus *bus) { return {bus->transfers(HUB_ADDRESS), bus->payload_bytes()}; }
+  Counters since(const Counters &start) const {
+    return {this->transfers - start.transfers, this->bytes - start.bytes};
+  }
+};
+
+static uint32_t percentile(std::vector<uint32_t> samples, uint8_t percent) {
+  if (samples.empty())
+    return 0;
+  std::sort(samples.begin(), samples.end());
+  size_t rank = (samples.size() * percent + 99) / 100;
+  return samples[std::max<size_t>(rank, 1) - 1];
+}
+
+static uint32_t elapsed_us(uint64_t start) { return host::now_us() - start; }
+
+/// Run one scenario and print its row, false if the hub did not do its job.
+static bool run(const Scenario &scenario, uint32_t sweeps) {
+  host::preferences().erase();
+  host::reset_log_counts();
+  // Hub groups are kept per bus for the whole process, like the worker test nothing here is freed
+  SimBus *bus = new_bus();
+  auto *chip = new DS2482(CHANNELS);  // NOLINT(cppcoreguidelines-owning-memory)
+  DallasComponent *hub = new_hub(bus, chip, HUB_ADDRESS, CHANNELS);
+  std::vector<DallasTemperatureSensor *> sensors;
+  for (uint8_t i = 0; i < scenario.sensors; i++) {
+    auto *device = new DS18x20(DS18x20::DS18B20, i + 1, 20.0f + i / 16.0f);  // NOLINT(cppcoreguidelines-owning-memory)
+    device->parasite = scenario.parasite;
+    chip->channel(i % CHANNELS).attach(device);
+    sensors.push_back(new_sensor(hub, *device, i % CHANNELS, scenario.resolution));
+  }
+  // Sweeps are started by hand, not by the runner's update schedule
+  LoopRunner runner;
+  runner.add(static_cast<Component *>(hub));
+
+  Counters start = Counters::of(bus);
+  uint64_t setup_start = host::now_us();
+  runner.setup();
+  uint32_t setup_us = elapsed_us(setup_start);
+  Counters setup = Counters::of(bus).since(start);
+
+  start = Counters::of(bus);
+  std::vector<uint32_t> read_us;
+  bool ok = true;
+  for (auto *sensor : sensors) {
+    uint64_t read_start = host::now_us();
+    ok &= sensor->read_scratch_pad() && sensor->check_scratch_pad();
+    read_us.push_back(elapsed_us(read_start));
+  }
+  Counters reads = Counters::of(bus).since(start);
+
+  runner.run_for(SWEEP_GAP_MS);
+  runner.reset_stats();
+  start = Counters::of(bus);
+  std::vector<uint32_t> update_us;
+  std::vector<uint32_t> sweep_us;
+  for (uint32_t n = 1; n <= sweeps && ok; n++) {
+    uint64_t sweep_start = host::now_us();
+    hub->update();
+    update_us.push_back(elapsed_us(sweep_start));
+    ok = runner.run_until(
+        [&]() {
+          return std::all_of(sensors.begin(), sensors.end(),
+                             [n](DallasTemperatureSensor *sensor) { return sensor->get_publishes() >= n; });
+        },
+        SWEEP_TIMEOUT_MS);
+    sweep_us.push_back(elapsed_us(sweep_start));
+    runner.run_for(SWEEP_GAP_MS);
+  }
+  Counters swept = Counters::of(bus).since(start);
+  std::vector<uint32_t> blocking = runner.call_us();
+  blocking.insert(blocking.end(), update_us.begin(), update_us.end());
+
+  ok &= chip->stats().busy_violations == 0 && chip->stats().bad_transfers == 0;
+  ok &= host::log_count(ESPHOME_LOG_LEVEL_WARN) == 0;
+  float per_sensor = float(scenario.sensors);
+  float per_read = per_sensor * sweep_us.size();
+  printf("%7u %3u %-8s | %7.1f %7.1f | %6.1f %7u | %7.1f %7.1f | %7.1f %7.1f | %6u %6u %6u | %s\n",
+         scenario.sensors, scenario.resolution, scenario.parasite ? "parasite" : "external", setup_us / 1000.0f,
+         setup.transfers / per_sensor, reads.transfers / per_sensor, percentile(read_us, 50),
+         percentile(sweep_us, 50) / 1000.0f, percentile(sweep_us, 99) / 1000.0f, swept.transfers / per_read,
+         swept.bytes / per_read, percentile(blocking, 50), percentile(blocking, 99),
+         *std::max_element(blocking.begin(), blocking.end()), ok ? "ok" : "FAILED");
+  return ok;
+}
+
+}  // namespace sim
+}  // namespace esphome
+
+int main(int argc, char **argv) {
+  using esphome::sim::Scenario;
+  uint32_t sweeps = argc > 1 ? std::max(atoi(argv[1]), 1) : 20;
+  const Scenario scenarios[] = {
+      {8, 12, false}, {32, 12, false}, {64, 12, false}, {64, 9, false}, {16, 12, true},
+  };
+
+  printf("%20s | %-15s | %-14s | %-15s | %-15s | %-20s |\n", "", "setup()", "scratch pad", "sweep ms",
+         "sensor in sweep", "loop blocking us");
+  printf("%7s %3s %-8s | %7s %7s | %6s %7s | %7s %7s | %7s %7s | %6s %6s %6s |\n", "sensors", "res", "power", "ms",
+         "xfers", "xfers", "us", "p50", "p99", "xfers", "bytes", "p50", "p99", "max");
+  bool ok = true;
+  for (const auto &scenario : scenarios)
+    ok &= esphome::sim::run(scenario, sweeps);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace i2c {
+
+enum ErrorCode {
+  NO_ERROR = 0,
+  ERROR_OK = 0,
+  ERROR_INVALID_ARGUMENT = 1,
+  ERROR_NOT_ACKNOWLEDGED = 2,
+  ERROR_TIMEOUT = 3,
+  ERROR_NOT_INITIALIZED = 4,
+  ERROR_TOO_LARGE = 5,
+  ERROR_UNKNOWN = 6,
+  ERROR_CRC = 7,
+};
+
+struct ReadBuffer {
+  uint8_t *data;
+  size_t len;
+};
+
+struct WriteBuffer {
+  const uint8_t *data;
+  size_t len;
+};
+
+class I2CBus {
+ public:
+  virtual ~I2CBus() = default;
+
+  virtual ErrorCode readv(uint8_t address, ReadBuffer *buffers, size_t cnt) = 0;
+  /// `stop` false leaves the bus to a repeated start.
+  virtual ErrorCode writev(uint8_t address, WriteBuffer *buffers, size_t cnt, bool stop) = 0;
+
+  ErrorCode read(uint8_t address, uint8_t *buffer, size_t len) {
+    ReadBuffer buf{buffer, len};
+    return this->readv(address, &buf, 1);
+  }
+  ErrorCode write(uint8_t address, const uint8_t *buffer, size_t len, bool stop = true) {
+    WriteBuffer buf{buffer, len};
+    return this->writev(address, &buf, 1, stop);
+  }
+};
+
+class I2CDevice {
+ public:
+  I2CDevice() = default;
+  void set_i2c_address(uint8_t address) { this->address_ = address; }
+  void set_i2c_bus(I2CBus *bus) { this->bus_ = bus; }
+  uint8_t get_i2c_address() const { return this->address_; }
+
+  ErrorCode read(uint8_t *data, size_t len) { return this->bus_->read(this->address_, data, len); }
+  ErrorCode write(const uint8_t *data, size_t len, bool stop = true) {
+    return this->bus_->write(this->address_, data, len, stop);
+  }
+  ErrorCode read_register(uint8_t a_register, uint8_t *data, size_t len, bool stop = true) {
+    ErrorCode err = this->write(&a_register, 1, stop);
+    if (err != ERROR_OK)
+      return err;
+    return this->read(data, len);
+  }
+  ErrorCode write_register(uint8_t a_register, const uint8_t *data, size_t len, bool stop = true) {
+    WriteBuffer buffers[2] = {{&a_register, 1}, {data, len}};
+    return this->bus_->writev(this->address_, buffers, 2, stop);
+  }
+
+ protected:
+  uint8_t address_{0x00};
+  I2CBus *bus_{nullptr};
+};
+
+}  // namespace i2c
+}  // namespace esphome
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+class EntityBase {
+ public:
+  const std::string &get_name() const { return this->name_; }
+  void set_name(const std::string &name) { this->name_ = name; }
+
+ protected:
+  std::string name_;
+};
+
+namespace sensor {
+
+/// Records what gets published, for the tests to look at.
+class Sensor : public EntityBase {
+ public:
+  virtual ~Sensor() = default;
+
+  void publish_state(float state) {
+    this->state = state;
+    this->has_state_ = true;
+    this->publishes_++;
+    for (auto &callback : this->callbacks_)
+      callback(state);
+  }
+  void add_on_state_callback(std::function<void(float)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  float get_state() const { return this->state; }
+  bool has_state() const { return this->has_state_; }
+  uint32_t get_publishes() const { return this->publishes_; }
+  virtual std::string unique_id() { return ""; }
+
+  float state{NAN};
+
+ protected:
+  bool has_state_{false};
+  uint32_t publishes_{0};
+  std::vector<std::function<void(float)>> callbacks_;
+};
+
+}  // namespace sensor
+}  // namespace esphome
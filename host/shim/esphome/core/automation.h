@@ -0,0 +1,14 @@
+#pragma once
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+/// What the components' actions implement: play() with the trigger's arguments.
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(Ts... x) = 0;
+};
+
+}  // namespace esphome
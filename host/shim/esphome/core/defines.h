@@ -0,0 +1,3 @@
+#pragma once
+
+// Component defines (DALLAS_DS2482_*) come from the CMake targets.
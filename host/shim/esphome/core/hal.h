@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Host build of the ESPHome HAL: time comes from the simulated clock in
+// esphome/host/clock.h, so delays and bus transfers cost no real time.
+
+#define HOT
+#define IRAM_ATTR
+#define ALWAYS_INLINE inline
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
+namespace esphome {
+
+namespace gpio {
+enum Flags : uint8_t {
+  FLAG_NONE = 0x00,
+  FLAG_INPUT = 0x01,
+  FLAG_OUTPUT = 0x02,
+  FLAG_OPEN_DRAIN = 0x04,
+  FLAG_PULLUP = 0x08,
+  FLAG_PULLDOWN = 0x10,
+};
+}  // namespace gpio
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+uint8_t progmem_read_byte(const uint8_t *addr);
+
+class GPIOPin {
+ public:
+  virtual ~GPIOPin() = default;
+  virtual void setup() = 0;
+  virtual void pin_mode(gpio::Flags flags) = 0;
+  virtual bool digital_read() = 0;
+  virtual void digital_write(bool value) = 0;
+  virtual std::string dump_summary() const = 0;
+};
+
+class InternalGPIOPin : public GPIOPin {};
+
+}  // namespace esphome
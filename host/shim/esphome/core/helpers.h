@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/optional.h"
+
+namespace esphome {
+
+std::string format_hex(const uint8_t *data, size_t length);
+/// Big endian, as ESPHome formats integers.
+std::string format_hex(uint64_t value);
+std::string str_lower_case(const std::string &str);
+/// Dallas/Maxim CRC8.
+uint8_t crc8(uint8_t *data, uint8_t len);
+uint32_t fnv1_hash(const std::string &str);
+
+class Mutex {
+ public:
+  void lock() { this->mutex_.lock(); }
+  bool try_lock() { return this->mutex_.try_lock(); }
+  void unlock() { this->mutex_.unlock(); }
+
+ protected:
+  std::mutex mutex_;
+};
+
+class LockGuard {
+ public:
+  explicit LockGuard(Mutex &mutex) : mutex_(mutex) { this->mutex_.lock(); }
+  ~LockGuard() { this->mutex_.unlock(); }
+
+ protected:
+  Mutex &mutex_;
+};
+
+template<typename T> class Parented {
+ public:
+  Parented() = default;
+  explicit Parented(T *parent) : parent_(parent) {}
+  T *get_parent() const { return this->parent_; }
+  void set_parent(T *parent) { this->parent_ = parent; }
+
+ protected:
+  T *parent_{nullptr};
+};
+
+class HighFrequencyLoopRequester {
+ public:
+  void start();
+  void stop();
+  static bool is_high_frequency();
+
+ protected:
+  bool started_{false};
+};
+
+}  // namespace esphome
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace host {
+
+/// Simulated time in µs. millis(), micros() and the delays of the host HAL run on
+/// it, and the simulated I2C bus advances it by the duration of every transfer.
+uint64_t now_us();
+void advance_us(uint64_t us);
+void set_time_us(uint64_t us);
+
+/// Run on the real steady clock instead, for tests with threads of their own.
+/// Delays sleep then, and bus transfers take no extra time.
+void use_real_clock(bool real);
+bool real_clock();
+
+/// Loops started by HighFrequencyLoopRequester::start() and not stopped yet.
+uint32_t high_frequency_requests();
+
+}  // namespace host
+}  // namespace esphome
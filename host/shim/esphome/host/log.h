@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace host {
+
+/// Lines up to `level` are printed, the default is ESPHOME_LOG_LEVEL_WARN or
+/// the level in the DALLAS_HOST_LOG environment variable.
+void set_log_level(int level);
+/// Lines logged at `level` since the last reset_log_counts(), printed or not.
+uint32_t log_count(int level);
+void reset_log_counts();
+/// Also keep every line logged from now on in `lines`, without level and tag; nullptr to stop.
+void capture_log(std::vector<std::string> *lines);
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+namespace host {
+
+/// Preferences kept in memory, global_preferences of the host build.
+///
+/// A flash budget emulates small targets: an ESP8266 keeps all flash
+/// preferences in 128 words, a save that doesn't fit fails there as well.
+class HostPreferences : public ESPPreferences {
+ public:
+  ESPPreferenceObject make_preference(size_t length, uint32_t type, bool in_flash) override;
+  bool sync() override { return true; }
+
+  /// Bytes all flash preferences may take together, 0 for no limit.
+  void set_flash_budget(size_t bytes) { this->flash_budget_ = bytes; }
+  /// Forget all stored data, as after erasing the flash.
+  void erase();
+  size_t flash_used() const;
+  uint32_t saves() const { return this->saves_; }
+
+ protected:
+  friend class HostPreference;
+  struct Record {
+    size_t length;
+    bool in_flash;
+    std::vector<uint8_t> data;
+  };
+  std::map<uint32_t, Record> records_;
+  std::vector<std::unique_ptr<ESPPreferenceBackend>> backends_;
+  size_t flash_budget_{0};
+  uint32_t saves_{0};
+};
+
+HostPreferences &preferences();
+
+}  // namespace host
+}  // namespace esphome
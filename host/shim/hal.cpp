@@ -0,0 +1,77 @@
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/host/clock.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace esphome {
+namespace host {
+
+static std::atomic<uint64_t> sim_time{0};  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<bool> use_real{false};  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static const auto real_epoch = std::chrono::steady_clock::now();
+static std::atomic<uint32_t> high_frequency{0};  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+uint64_t now_us() {
+  if (use_real)
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - real_epoch).count();
+  return sim_time.load();
+}
+
+void advance_us(uint64_t us) {
+  if (!use_real)
+    sim_time += us;
+}
+
+void set_time_us(uint64_t us) { sim_time = us; }
+void use_real_clock(bool real) { use_real = real; }
+bool real_clock() { return use_real; }
+uint32_t high_frequency_requests() { return high_frequency; }
+
+}  // namespace host
+
+uint32_t millis() { return host::now_us() / 1000; }
+uint32_t micros() { return host::now_us(); }
+
+void delay(uint32_t ms) {
+  if (host::real_clock()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  } else {
+    host::advance_us(uint64_t(ms) * 1000);
+  }
+}
+
+void delayMicroseconds(uint32_t us) {
+  if (host::real_clock()) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  } else {
+    host::advance_us(us);
+  }
+}
+
+void yield() {
+  if (host::real_clock())
+    std::this_thread::yield();
+}
+
+uint8_t progmem_read_byte(const uint8_t *addr) { return *addr; }
+
+void HighFrequencyLoopRequester::start() {
+  if (this->started_)
+    return;
+  this->started_ = true;
+  host::high_frequency++;
+}
+
+void HighFrequencyLoopRequester::stop() {
+  if (!this->started_)
+    return;
+  this->started_ = false;
+  host::high_frequency--;
+}
+
+bool HighFrequencyLoopRequester::is_high_frequency() { return host::high_frequency != 0; }
+
+}  // namespace esphome
@@ -0,0 +1,56 @@
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace esphome {
+
+std::string format_hex(const uint8_t *data, size_t length) {
+  static const char *const DIGITS = "0123456789abcdef";
+  std::string ret;
+  ret.reserve(length * 2);
+  for (size_t i = 0; i < length; i++) {
+    ret += DIGITS[data[i] >> 4];
+    ret += DIGITS[data[i] & 0x0F];
+  }
+  return ret;
+}
+
+std::string format_hex(uint64_t value) {
+  uint8_t bytes[8];
+  for (uint8_t i = 0; i < 8; i++)
+    bytes[i] = value >> (56 - 8 * i);
+  return format_hex(bytes, sizeof(bytes));
+}
+
+std::string str_lower_case(const std::string &str) {
+  std::string ret = str;
+  std::transform(ret.begin(), ret.end(), ret.begin(), [](unsigned char c) { return std::tolower(c); });
+  return ret;
+}
+
+uint8_t crc8(uint8_t *data, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    uint8_t inbyte = *data++;
+    for (uint8_t i = 8; i; i--) {
+      bool mix = (crc ^ inbyte) & 0x01;
+      crc >>= 1;
+      if (mix)
+        crc ^= 0x8C;
+      inbyte >>= 1;
+    }
+  }
+  return crc;
+}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= c;
+  }
+  return hash;
+}
+
+}  // namespace esphome
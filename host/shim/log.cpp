@@ -0,0 +1,59 @@
+#include "esphome/host/log.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdlib>
+#include <mutex>
+
+namespace esphome {
+namespace host {
+
+static const char LEVEL_LETTERS[] = "-EWICDVV";
+
+static int initial_level() {
+  const char *env = std::getenv("DALLAS_HOST_LOG");
+  return env != nullptr ? std::atoi(env) : ESPHOME_LOG_LEVEL_WARN;
+}
+
+static std::atomic<int> log_level{initial_level()};  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<uint32_t> counts[ESPHOME_LOG_LEVEL_VERY_VERBOSE + 1];  // NOLINT
+static std::mutex print_lock;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::vector<std::string> *captured{nullptr};  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+void log_printf(int level, const char *tag, const char *format, ...) {
+  counts[level]++;
+  std::lock_guard<std::mutex> guard(print_lock);
+  if (captured != nullptr) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    captured->emplace_back(line);
+  }
+  if (level > log_level)
+    return;
+
+  std::printf("[%c][%s] ", LEVEL_LETTERS[level], tag);
+  va_list args;
+  va_start(args, format);
+  std::vprintf(format, args);
+  va_end(args);
+  std::printf("\n");
+}
+
+void set_log_level(int level) { log_level = level; }
+
+void capture_log(std::vector<std::string> *lines) {
+  std::lock_guard<std::mutex> guard(print_lock);
+  captured = lines;
+}
+uint32_t log_count(int level) { return counts[level]; }
+
+void reset_log_counts() {
+  for (auto &count : counts)
+    count = 0;
+}
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,79 @@
+#include "esphome/host/preferences.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace host {
+
+/// Flash a preference takes on an ESP8266: whole words of data and a CRC word.
+static size_t flash_size(size_t length) { return (length + 3) / 4 * 4 + 4; }
+
+/// One preference, bound to its key in the store.
+class HostPreference : public ESPPreferenceBackend {
+ public:
+  HostPreference(HostPreferences *store, uint32_t key, size_t length, bool in_flash)
+      : store_(store), key_(key), length_(length), in_flash_(in_flash) {}
+
+  bool save(const uint8_t *data, size_t len) override {
+    if (len != this->length_)
+      return false;
+    auto &records = this->store_->records_;
+    size_t budget = this->store_->flash_budget_;
+    if (this->in_flash_ && budget != 0) {
+      size_t used = this->store_->flash_used();
+      auto it = records.find(this->key_);
+      if (it != records.end() && it->second.in_flash)
+        used -= flash_size(it->second.length);
+      if (used + flash_size(len) > budget)
+        return false;
+    }
+    records[this->key_] = {len, this->in_flash_, std::vector<uint8_t>(data, data + len)};
+    this->store_->saves_++;
+    return true;
+  }
+
+  bool load(uint8_t *data, size_t len) override {
+    auto &records = this->store_->records_;
+    auto it = records.find(this->key_);
+    if (it == records.end() || it->second.length != len)
+      return false;
+    memcpy(data, it->second.data.data(), len);
+    return true;
+  }
+
+ protected:
+  HostPreferences *store_;
+  uint32_t key_;
+  size_t length_;
+  bool in_flash_;
+};
+
+ESPPreferenceObject HostPreferences::make_preference(size_t length, uint32_t type, bool in_flash) {
+  this->backends_.push_back(std::unique_ptr<ESPPreferenceBackend>(new HostPreference(this, type, length, in_flash)));
+  return ESPPreferenceObject(this->backends_.back().get());
+}
+
+void HostPreferences::erase() {
+  this->records_.clear();
+  this->saves_ = 0;
+}
+
+size_t HostPreferences::flash_used() const {
+  size_t used = 0;
+  for (const auto &it : this->records_) {
+    if (it.second.in_flash)
+      used += flash_size(it.second.length);
+  }
+  return used;
+}
+
+HostPreferences &preferences() {
+  static HostPreferences store;
+  return store;
+}
+
+}  // namespace host
+
+ESPPreferences *global_preferences = &host::preferences();  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+}  // namespace esphome
@@ -0,0 +1,281 @@
+#include "ds2482.h"
+
+#include "esphome/host/clock.h"
+
+namespace esphome {
+namespace sim {
+
+static const uint8_t CMD_DEVICE_RESET = 0xF0;
+static const uint8_t CMD_SET_READ_POINTER = 0xE1;
+static const uint8_t CMD_WRITE_CONFIG = 0xD2;
+static const uint8_t CMD_CHANNEL_SELECT = 0xC3;
+static const uint8_t CMD_WIRE_RESET = 0xB4;
+static const uint8_t CMD_WIRE_WRITE_BYTE = 0xA5;
+static const uint8_t CMD_WIRE_READ_BYTE = 0x96;
+static const uint8_t CMD_WIRE_SINGLE_BIT = 0x87;
+static const uint8_t CMD_WIRE_TRIPLET = 0x78;
+
+static const uint8_t POINTER_STATUS = 0xF0;
+static const uint8_t POINTER_DATA = 0xE1;
+static const uint8_t POINTER_CHANNEL = 0xD2;
+static const uint8_t POINTER_CONFIG = 0xC3;
+
+static const uint8_t STATUS_1WB = 1 << 0;
+static const uint8_t STATUS_PPD = 1 << 1;
+static const uint8_t STATUS_SD = 1 << 2;
+static const uint8_t STATUS_LL = 1 << 3;
+static const uint8_t STATUS_RST = 1 << 4;
+static const uint8_t STATUS_SBR = 1 << 5;
+static const uint8_t STATUS_TSB = 1 << 6;
+static const uint8_t STATUS_DIR = 1 << 7;
+
+static const uint8_t CONFIG_SPU = 1 << 2;
+static const uint8_t CONFIG_1WS = 1 << 3;
+
+static const uint8_t CHANNEL_SELECT_CODES[] = {0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87};
+static const uint8_t CHANNEL_READ_CODES[] = {0xB8, 0xB1, 0xAA, 0xA3, 0x9C, 0x95, 0x8E, 0x87};
+
+// Typical 1-Wire timing of the state machine, standard and overdrive speed
+static const uint32_t RESET_STD_US = 1148;
+static const uint32_t RESET_OVD_US = 146;
+static const uint32_t SLOT_STD_US = 72;
+static const uint32_t SLOT_OVD_US = 11;
+
+DS2482::DS2482(uint8_t channels) : channels_(channels) { this->device_reset_(); }
+
+uint32_t DS2482::reset_us_() const {
+  return ((this->config_ & CONFIG_1WS) ? RESET_OVD_US : RESET_STD_US) * this->timing_scale_;
+}
+
+uint32_t DS2482::slot_us_() const {
+  return ((this->config_ & CONFIG_1WS) ? SLOT_OVD_US : SLOT_STD_US) * this->timing_scale_;
+}
+
+bool DS2482::busy_() const { return host::now_us() < this->busy_until_; }
+
+void DS2482::settle_() {
+  if (!this->pending_ || this->busy_())
+    return;
+  this->status_ = this->pending_status_;
+  this->data_ = this->pending_data_;
+  this->pending_ = false;
+}
+
+void DS2482::start_(uint32_t duration, uint8_t status, uint8_t data) {
+  this->busy_until_ = this->stuck_busy ? UINT64_MAX : host::now_us() + duration;
+  this->pending_ = true;
+  this->pending_status_ = status & ~STATUS_1WB;
+  this->pending_data_ = data;
+  this->pointer_ = POINTER_STATUS;
+  this->stats_.wire_us += duration;
+}
+
+void DS2482::end_pullup_() {
+  if (!this->pullup_active_)
+    return;
+  this->channels_[this->channel_].release_pullup(host::now_us());
+  this->pullup_active_ = false;
+  this->config_ &= ~CONFIG_SPU;
+}
+
+void DS2482::arm_pullup_() {
+  bool spu = this->config_ & CONFIG_SPU;
+  this->channels_[this->channel_].set_pullup_armed(spu);
+  this->pullup_active_ = spu;
+}
+
+void DS2482::device_reset_() {
+  this->end_pullup_();
+  this->config_ = 0;
+  this->channel_ = 0;
+  this->pointer_ = POINTER_STATUS;
+  this->status_ = STATUS_RST;
+  this->busy_until_ = 0;
+  this->pending_ = false;
+}
+
+bool DS2482::i2c_write(const uint8_t *data, size_t len) {
+  this->stats_.transfers++;
+  if (this->nack_transfers != 0) {
+    this->nack_transfers--;
+    return false;
+  }
+  if (len == 0)
+    return true;
+  this->settle_();
+
+  uint8_t command = data[0];
+  switch (command) {
+    case CMD_DEVICE_RESET:
+      if (len != 1)
+        break;
+      this->device_reset_();
+      return true;
+
+    case CMD_SET_READ_POINTER: {
+      if (len != 2)
+        break;
+      uint8_t pointer = data[1];
+      if (pointer != POINTER_STATUS && pointer != POINTER_DATA && pointer != POINTER_CONFIG &&
+          !(pointer == POINTER_CHANNEL && this->channels_.size() > 1))
+        break;
+      this->pointer_ = pointer;
+      return true;
+    }
+
+    case CMD_WRITE_CONFIG: {
+      if (len != 2)
+        break;
+      if (this->busy_()) {
+        this->stats_.busy_violations++;
+        return false;
+      }
+      uint8_t config = data[1] & 0x0F;
+      if ((data[1] >> 4) != (~config & 0x0F))
+        break;
+      if (!(config & CONFIG_SPU))
+        this->end_pullup_();
+      this->config_ = config;
+      this->status_ &= ~STATUS_RST;
+      this->pointer_ = POINTER_CONFIG;
+      this->stats_.config_writes++;
+      return true;
+    }
+
+    case CMD_CHANNEL_SELECT: {
+      if (len != 2 || this->channels_.size() == 1)
+        break;
+      if (this->busy_()) {
+        this->stats_.busy_violations++;
+        return false;
+      }
+      uint8_t channel = 0;
+      while (channel < this->channels_.size() && CHANNEL_SELECT_CODES[channel] != data[1])
+        channel++;
+      if (channel == this->channels_.size())
+        break;
+      this->end_pullup_();
+      this->channel_ = channel;
+      this->pointer_ = POINTER_CHANNEL;
+      this->stats_.channel_selects++;
+      return true;
+    }
+
+    case CMD_WIRE_RESET:
+    case CMD_WIRE_WRITE_BYTE:
+    case CMD_WIRE_READ_BYTE:
+    case CMD_WIRE_SINGLE_BIT:
+    case CMD_WIRE_TRIPLET:
+      if (this->busy_()) {
+        this->stats_.busy_violations++;
+        return false;
+      }
+      if (this->wire_command_(command, data, len))
+        return true;
+      break;
+
+    default:
+      break;
+  }
+
+  this->stats_.bad_transfers++;
+  return false;
+}
+
+bool DS2482::wire_command_(uint8_t command, const uint8_t *data, size_t len) {
+  uint64_t now = host::now_us();
+  auto &channel = this->channels_[this->channel_];
+  uint8_t status = this->status_;
+
+  if (len != (command == CMD_WIRE_RESET || command == CMD_WIRE_READ_BYTE ? 1u : 2u))
+    return false;
+  this->end_pullup_();
+
+  switch (command) {
+    case CMD_WIRE_RESET: {
+      channel.set_pullup_armed(false);
+      // None of the simulated devices speaks overdrive
+      bool presence = !(this->config_ & CONFIG_1WS) && channel.reset(now);
+      status &= ~(STATUS_PPD | STATUS_SD);
+      if (presence)
+        status |= STATUS_PPD;
+      if (channel.shorted)
+        status |= STATUS_SD;
+      this->stats_.resets++;
+      this->start_(this->reset_us_(), status, this->data_);
+      return true;
+    }
+    case CMD_WIRE_WRITE_BYTE:
+      this->arm_pullup_();
+      channel.write_byte(data[1], now);
+      this->stats_.bytes_written++;
+      this->start_(8 * this->slot_us_(), status, this->data_);
+      return true;
+    case CMD_WIRE_READ_BYTE: {
+      this->arm_pullup_();
+      uint8_t byte = channel.read_byte(now);
+      this->stats_.bytes_read++;
+      this->start_(8 * this->slot_us_(), status, byte);
+      return true;
+    }
+    case CMD_WIRE_SINGLE_BIT: {
+      this->arm_pullup_();
+      bool bit = channel.slot(data[1] & 0x80, now);
+      status = (status & ~STATUS_SBR) | (bit ? STATUS_SBR : 0);
+      this->stats_.bits++;
+      this->start_(this->slot_us_(), status, this->data_);
+      return true;
+    }
+    case CMD_WIRE_TRIPLET: {
+      channel.set_pullup_armed(false);
+      bool id = channel.slot(true, now);
+      bool comp_id = channel.slot(true, now);
+      // Devices all agree: follow them, otherwise take the direction asked for
+      bool direction = id != comp_id ? id : bool(data[1] & 0x80);
+      channel.slot(direction, now);
+      status &= ~(STATUS_SBR | STATUS_TSB | STATUS_DIR);
+      status |= (id ? STATUS_SBR : 0) | (comp_id ? STATUS_TSB : 0) | (direction ? STATUS_DIR : 0);
+      this->stats_.triplets++;
+      this->start_(3 * this->slot_us_(), status, this->data_);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+uint8_t DS2482::read_register_() {
+  switch (this->pointer_) {
+    case POINTER_DATA:
+      return this->data_;
+    case POINTER_CONFIG:
+      return this->config_;
+    case POINTER_CHANNEL:
+      return CHANNEL_READ_CODES[this->channel_];
+    case POINTER_STATUS:
+    default: {
+      this->stats_.status_reads++;
+      uint8_t status = this->status_ & ~(STATUS_1WB | STATUS_LL);
+      if (this->busy_())
+        status |= STATUS_1WB;
+      if (!this->channels_[this->channel_].shorted)
+        status |= STATUS_LL;
+      return status;
+    }
+  }
+}
+
+bool DS2482::i2c_read(uint8_t *data, size_t len) {
+  this->stats_.transfers++;
+  if (this->nack_transfers != 0) {
+    this->nack_transfers--;
+    return false;
+  }
+  this->settle_();
+  for (size_t i = 0; i < len; i++)
+    data[i] = this->read_register_();
+  return true;
+}
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "one_wire.h"
+#include "sim_bus.h"
+
+namespace esphome {
+namespace sim {
+
+/// DS2482-100/-800 I2C to 1-Wire bridge.
+///
+/// Models the registers and read pointer, the channel selection codes, the
+/// config register with its complement check, 1WB for the duration of every
+/// 1-Wire command, the strong pullup and the triplet of the search algorithm.
+/// 1-Wire commands, config writes and channel selects arriving while 1WB is
+/// set are NACKed and counted, as are the other transfers a driver should
+/// never send.
+class DS2482 : public I2CTarget {
+ public:
+  struct Stats {
+    uint32_t transfers;
+    /// Commands sent while the 1-Wire line was still busy.
+    uint32_t busy_violations;
+    /// Transfers NACKed for being malformed or unknown.
+    uint32_t bad_transfers;
+    uint32_t resets;
+    uint32_t bytes_written;
+    uint32_t bytes_read;
+    uint32_t bits;
+    uint32_t triplets;
+    uint32_t channel_selects;
+    uint32_t config_writes;
+    uint32_t status_reads;
+    /// 1-Wire time the line was busy, µs.
+    uint64_t wire_us;
+  };
+
+  /// 8 channels for a DS2482-800, 1 for a DS2482-100.
+  explicit DS2482(uint8_t channels = 8);
+
+  OneWireChannel &channel(uint8_t channel) { return this->channels_[channel]; }
+  /// Stretch the 1-Wire timing, e.g. 1.1 for an oscillator at the slow end of its tolerance.
+  void set_timing_scale(float scale) { this->timing_scale_ = scale; }
+  uint8_t selected_channel() const { return this->channel_; }
+  uint8_t config() const { return this->config_; }
+  bool pullup_active() const { return this->pullup_active_; }
+  const Stats &stats() const { return this->stats_; }
+
+  /// NACK the next `nack_transfers` transfers, as a device that fell off the bus.
+  uint16_t nack_transfers{0};
+  /// 1WB stays set from the next 1-Wire command on.
+  bool stuck_busy{false};
+
+  bool i2c_write(const uint8_t *data, size_t len) override;
+  bool i2c_read(uint8_t *data, size_t len) override;
+
+ protected:
+  bool busy_() const;
+  /// Apply the result of the 1-Wire command once its time is up.
+  void settle_();
+  /// Start a 1-Wire command taking `duration` µs with the given result.
+  void start_(uint32_t duration, uint8_t status, uint8_t data);
+  /// A new command ends the strong pullup, SPU clears itself.
+  void end_pullup_();
+  /// Feed the channel with the strong pullup armed for what follows, if SPU is set.
+  void arm_pullup_();
+  void device_reset_();
+  uint32_t reset_us_() const;
+  uint32_t slot_us_() const;
+  uint8_t read_register_();
+  /// 1-Wire command, false if it is refused.
+  bool wire_command_(uint8_t command, const uint8_t *data, size_t len);
+
+  std::vector<OneWireChannel> channels_;
+  float timing_scale_{1.0f};
+  Stats stats_{};
+
+  uint8_t channel_{0};
+  uint8_t config_{0};
+  uint8_t pointer_;
+  uint8_t status_;
+  uint8_t data_{0xFF};
+  uint64_t busy_until_{0};
+  bool pending_{false};
+  uint8_t pending_status_{0};
+  uint8_t pending_data_{0};
+  bool pullup_active_{false};
+};
+
+}  // namespace sim
+}  // namespace esphome
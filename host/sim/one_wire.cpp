@@ -0,0 +1,397 @@
+#include "one_wire.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace esphome {
+namespace sim {
+
+static const uint8_t CMD_READ_ROM = 0x33;
+static const uint8_t CMD_MATCH_ROM = 0x55;
+static const uint8_t CMD_SKIP_ROM = 0xCC;
+static const uint8_t CMD_SEARCH_ROM = 0xF0;
+static const uint8_t CMD_ALARM_SEARCH = 0xEC;
+static const uint8_t CMD_RESUME = 0xA5;
+static const uint8_t CMD_CONVERT_T = 0x44;
+static const uint8_t CMD_READ_SCRATCH_PAD = 0xBE;
+static const uint8_t CMD_WRITE_SCRATCH_PAD = 0x4E;
+static const uint8_t CMD_COPY_SCRATCH_PAD = 0x48;
+static const uint8_t CMD_RECALL_E2 = 0xB8;
+static const uint8_t CMD_READ_POWER_SUPPLY = 0xB4;
+
+/// Worst case conversion time at 9 bit, doubling with every bit.
+static const uint32_t CONVERSION_9BIT_US = 93750;
+static const uint32_t CONVERSION_DS18S20_US = 750000;
+
+static uint8_t dallas_crc8(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    uint8_t inbyte = *data++;
+    for (uint8_t i = 8; i; i--) {
+      bool mix = (crc ^ inbyte) & 0x01;
+      crc >>= 1;
+      if (mix)
+        crc ^= 0x8C;
+      inbyte >>= 1;
+    }
+  }
+  return crc;
+}
+
+DS18x20::DS18x20(uint8_t family, uint64_t serial, float temperature) : temperature(temperature) {
+  uint8_t rom[8];
+  rom[0] = family;
+  for (uint8_t i = 0; i < 6; i++)
+    rom[1 + i] = serial >> (8 * i);
+  rom[7] = dallas_crc8(rom, 7);
+  this->rom_ = 0;
+  for (uint8_t i = 0; i < 8; i++)
+    this->rom_ |= uint64_t(rom[i]) << (8 * i);
+
+  // Factory defaults: TH 75 °C, TL 70 °C, 12 bit
+  this->eeprom_[0] = 75;
+  this->eeprom_[1] = 70;
+  this->eeprom_[2] = family == DS18S20 ? 0xFF : 0x7F;
+  this->power_on_();
+}
+
+uint8_t DS18x20::resolution() const {
+  if (this->family() == DS18S20)
+    return 9;
+  return 9 + ((this->registers_[2] >> 5) & 0x03);
+}
+
+void DS18x20::power_on_() {
+  // 85 °C until the first conversion
+  this->temp_raw_ = this->family() == DS18S20 ? 0x00AA : 0x0550;
+  this->count_remain_ = 0x0C;
+  memcpy(this->registers_, this->eeprom_, sizeof(this->registers_));
+  this->mode_ = Mode::IDLE;
+  this->converting_ = false;
+  this->copying_ = false;
+  this->resume_ = false;
+}
+
+void DS18x20::finish_(uint64_t now) {
+  if (this->converting_ && now >= this->busy_until_) {
+    this->converting_ = false;
+    this->store_temperature_();
+    this->stats_.conversions++;
+  }
+  if (this->copying_ && now >= this->busy_until_) {
+    this->copying_ = false;
+    memcpy(this->eeprom_, this->registers_, sizeof(this->eeprom_));
+    this->stats_.eeprom_writes++;
+  }
+}
+
+void DS18x20::store_temperature_() {
+  float t = std::min(std::max(this->temperature, -55.0f), 125.0f);
+  int whole;
+  if (this->family() == DS18S20) {
+    // TEMP_READ in half degrees with the 0.5 bit truncated, COUNT_REMAIN for the rest:
+    // T = TEMP_READ - 0.25 + (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C
+    whole = int(std::floor(t + 0.25f));
+    long remain = 12 - std::lround(16 * (t - whole));
+    this->count_remain_ = std::min<long>(std::max<long>(remain, 1), 16);
+    this->temp_raw_ = whole * 2;
+  } else {
+    int raw = int(std::lround(t * 16));
+    raw &= ~((1 << (12 - this->resolution())) - 1);
+    this->temp_raw_ = raw;
+    whole = raw >> 4;
+  }
+  this->alarm_ = whole >= int8_t(this->registers_[0]) || whole <= int8_t(this->registers_[1]);
+}
+
+void DS18x20::fill_scratch_pad_(uint8_t *scratch_pad) const {
+  scratch_pad[0] = this->temp_raw_ & 0xFF;
+  scratch_pad[1] = uint16_t(this->temp_raw_) >> 8;
+  scratch_pad[2] = this->registers_[0];
+  scratch_pad[3] = this->registers_[1];
+  if (this->family() == DS18S20) {
+    scratch_pad[4] = 0xFF;
+    scratch_pad[5] = 0xFF;
+    scratch_pad[6] = this->count_remain_;
+  } else {
+    scratch_pad[4] = this->registers_[2];
+    scratch_pad[5] = 0xFF;
+    scratch_pad[6] = 0x0C;
+  }
+  scratch_pad[7] = 0x10;
+  scratch_pad[8] = dallas_crc8(scratch_pad, 8);
+}
+
+bool DS18x20::reset(uint64_t now) {
+  this->finish_(now);
+  if (!this->connected) {
+    this->mode_ = Mode::IDLE;
+    return false;
+  }
+  if (this->copying_) {
+    // The EEPROM write is lost, the EEPROM keeps its old contents
+    this->copying_ = false;
+    this->stats_.interrupted_copies++;
+  }
+  this->mode_ = Mode::ROM;
+  this->rx_byte_ = 0;
+  this->rx_bits_ = 0;
+  return true;
+}
+
+bool DS18x20::slot(bool bit, uint64_t now) {
+  this->finish_(now);
+  if (!this->connected)
+    return true;
+
+  switch (this->mode_) {
+    case Mode::ROM:
+    case Mode::MATCH:
+    case Mode::FUNCTION:
+    case Mode::WRITE:
+      if (bit)
+        this->rx_byte_ |= 1 << this->rx_bits_;
+      if (++this->rx_bits_ == 8) {
+        uint8_t byte = this->rx_byte_;
+        this->rx_byte_ = 0;
+        this->rx_bits_ = 0;
+        this->receive_(byte, now);
+      }
+      return true;
+    case Mode::SEND: {
+      if (this->tx_bit_ >= this->tx_len_ * 8)
+        return true;
+      bool out = (this->tx_[this->tx_bit_ / 8] >> (this->tx_bit_ % 8)) & 1;
+      this->tx_bit_++;
+      return out;
+    }
+    case Mode::SEARCH: {
+      bool rom_bit = (this->rom_ >> this->search_bit_) & 1;
+      if (this->search_phase_ == 0) {
+        this->search_phase_ = 1;
+        return rom_bit;
+      }
+      if (this->search_phase_ == 1) {
+        this->search_phase_ = 2;
+        return !rom_bit;
+      }
+      // The direction the master wrote, devices with the other bit drop out
+      if (bit != rom_bit) {
+        this->mode_ = Mode::IDLE;
+        this->resume_ = false;
+        return true;
+      }
+      this->search_phase_ = 0;
+      if (++this->search_bit_ == 64) {
+        this->mode_ = Mode::FUNCTION;
+        this->resume_ = this->can_resume_();
+      }
+      return true;
+    }
+    case Mode::BUSY:
+      // Read slots answer 0 until the conversion or EEPROM write is done
+      return !(this->converting_ || this->copying_);
+    case Mode::POWER:
+      return !this->parasite;
+    case Mode::IDLE:
+    default:
+      return true;
+  }
+}
+
+void DS18x20::receive_(uint8_t byte, uint64_t now) {
+  switch (this->mode_) {
+    case Mode::ROM:
+      this->rom_command_(byte);
+      break;
+    case Mode::MATCH:
+      this->match_ |= uint64_t(byte) << (8 * this->rx_count_);
+      if (++this->rx_count_ < 8)
+        break;
+      if (this->match_ == this->rom_) {
+        this->mode_ = Mode::FUNCTION;
+        this->resume_ = this->can_resume_();
+        this->stats_.matches++;
+      } else {
+        this->mode_ = Mode::IDLE;
+        this->resume_ = false;
+      }
+      break;
+    case Mode::FUNCTION:
+      this->function_command_(byte, now);
+      break;
+    case Mode::WRITE: {
+      bool ds18s20 = this->family() == DS18S20;
+      // Only the resolution bits of the configuration register are writable
+      this->registers_[this->rx_count_] = this->rx_count_ == 2 ? (byte & 0x60) | 0x1F : byte;
+      if (++this->rx_count_ == (ds18s20 ? 2 : 3))
+        this->mode_ = Mode::IDLE;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void DS18x20::rom_command_(uint8_t command) {
+  switch (command) {
+    case CMD_READ_ROM: {
+      uint8_t rom[8];
+      for (uint8_t i = 0; i < 8; i++)
+        rom[i] = this->rom_ >> (8 * i);
+      this->resume_ = false;
+      this->send_(rom, sizeof(rom));
+      break;
+    }
+    case CMD_MATCH_ROM:
+      this->mode_ = Mode::MATCH;
+      this->match_ = 0;
+      this->rx_count_ = 0;
+      break;
+    case CMD_SKIP_ROM:
+      this->mode_ = Mode::FUNCTION;
+      this->resume_ = false;
+      break;
+    case CMD_ALARM_SEARCH:
+    case CMD_SEARCH_ROM:
+      if (command == CMD_ALARM_SEARCH && !this->alarm_) {
+        this->mode_ = Mode::IDLE;
+        this->resume_ = false;
+        break;
+      }
+      this->mode_ = Mode::SEARCH;
+      this->search_bit_ = 0;
+      this->search_phase_ = 0;
+      break;
+    case CMD_RESUME:
+      // Not a command of the other families, they just stay out of it
+      if (this->can_resume_() && this->resume_) {
+        this->mode_ = Mode::FUNCTION;
+        this->stats_.resumes++;
+      } else {
+        this->mode_ = Mode::IDLE;
+      }
+      break;
+    default:
+      this->stats_.bad_commands++;
+      this->mode_ = Mode::IDLE;
+      this->resume_ = false;
+      break;
+  }
+}
+
+void DS18x20::function_command_(uint8_t command, uint64_t now) {
+  switch (command) {
+    case CMD_CONVERT_T: {
+      uint32_t worst = this->family() == DS18S20 ? CONVERSION_DS18S20_US
+                                                 : CONVERSION_9BIT_US << (this->resolution() - 9);
+      this->converting_ = true;
+      this->busy_until_ = now + uint64_t(worst * this->conversion_speed);
+      this->mode_ = Mode::BUSY;
+      break;
+    }
+    case CMD_READ_SCRATCH_PAD: {
+      uint8_t scratch_pad[9];
+      this->fill_scratch_pad_(scratch_pad);
+      if (this->crc_faults != 0) {
+        this->crc_faults--;
+        scratch_pad[8] ^= 0x01;
+      }
+      this->stats_.scratch_pad_reads++;
+      this->send_(scratch_pad, sizeof(scratch_pad));
+      return;
+    }
+    case CMD_WRITE_SCRATCH_PAD:
+      this->mode_ = Mode::WRITE;
+      this->rx_count_ = 0;
+      return;
+    case CMD_COPY_SCRATCH_PAD:
+      this->copying_ = true;
+      this->busy_until_ = now + this->copy_us;
+      this->mode_ = Mode::BUSY;
+      break;
+    case CMD_RECALL_E2:
+      memcpy(this->registers_, this->eeprom_, sizeof(this->registers_));
+      this->mode_ = Mode::BUSY;
+      return;
+    case CMD_READ_POWER_SUPPLY:
+      this->mode_ = Mode::POWER;
+      return;
+    default:
+      this->stats_.bad_commands++;
+      this->mode_ = Mode::IDLE;
+      return;
+  }
+
+  // Parasite devices draw their power for a conversion or EEPROM write from the
+  // strong pullup, which must come on right after this byte
+  if (this->parasite && !this->channel_->pullup_armed()) {
+    this->stats_.brownouts++;
+    this->power_on_();
+  }
+}
+
+void DS18x20::send_(const uint8_t *data, uint8_t len) {
+  memcpy(this->tx_, data, len);
+  this->tx_len_ = len;
+  this->tx_bit_ = 0;
+  this->mode_ = Mode::SEND;
+}
+
+void DS18x20::pullup_released(uint64_t now) {
+  this->finish_(now);
+  if (this->parasite && (this->converting_ || this->copying_)) {
+    this->stats_.brownouts++;
+    this->power_on_();
+  }
+}
+
+void OneWireChannel::attach(DS18x20 *device) {
+  this->devices_.push_back(device);
+  device->attach(this);
+}
+
+void OneWireChannel::detach(DS18x20 *device) {
+  this->devices_.erase(std::remove(this->devices_.begin(), this->devices_.end(), device), this->devices_.end());
+}
+
+bool OneWireChannel::reset(uint64_t now) {
+  this->resets_++;
+  bool presence = false;
+  for (auto *device : this->devices_)
+    presence |= device->reset(now);
+  return presence && !this->shorted && !this->presence_lost;
+}
+
+bool OneWireChannel::slot(bool bit, uint64_t now) {
+  bool line = true;
+  for (auto *device : this->devices_)
+    line &= device->slot(bit, now);
+  return line && !this->shorted;
+}
+
+void OneWireChannel::write_byte(uint8_t byte, uint64_t now) {
+  for (uint8_t i = 0; i < 8; i++)
+    this->slot((byte >> i) & 1, now);
+}
+
+uint8_t OneWireChannel::read_byte(uint64_t now) {
+  uint8_t byte = 0;
+  for (uint8_t i = 0; i < 8; i++) {
+    if (this->slot(true, now))
+      byte |= 1 << i;
+  }
+  return byte;
+}
+
+void OneWireChannel::release_pullup(uint64_t now) {
+  if (!this->pullup_armed_)
+    return;
+  this->pullup_armed_ = false;
+  for (auto *device : this->devices_)
+    device->pullup_released(now);
+}
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace sim {
+
+class OneWireChannel;
+
+/// DS18x20 family temperature sensor, simulated time slot by time slot.
+///
+/// ROM commands: READ ROM, MATCH ROM, SKIP ROM, SEARCH ROM, ALARM SEARCH and,
+/// for the DS28EA00 only, RESUME. Function commands: CONVERT T, READ/WRITE/COPY
+/// SCRATCHPAD, RECALL E2 and READ POWER SUPPLY. Conversions and EEPROM writes
+/// take their time on the simulated clock; parasite powered devices lose them
+/// when the strong pullup does not hold until they are done.
+class DS18x20 {
+ public:
+  static constexpr uint8_t DS18S20 = 0x10;
+  static constexpr uint8_t DS1822 = 0x22;
+  static constexpr uint8_t DS18B20 = 0x28;
+  static constexpr uint8_t DS1825 = 0x3B;
+  static constexpr uint8_t DS28EA00 = 0x42;
+
+  struct Stats {
+    uint32_t conversions;
+    /// Conversions or EEPROM writes lost to a missing strong pullup.
+    uint32_t brownouts;
+    uint32_t scratch_pad_reads;
+    uint32_t eeprom_writes;
+    /// EEPROM writes cut short by a reset before they were done.
+    uint32_t interrupted_copies;
+    uint32_t matches;
+    uint32_t resumes;
+    /// ROM or function commands the device does not know.
+    uint32_t bad_commands;
+  };
+
+  /// `serial` is the 48 bit serial number, the ROM gets the family code and CRC around it.
+  DS18x20(uint8_t family, uint64_t serial, float temperature = 21.5f);
+
+  uint64_t rom() const { return this->rom_; }
+  uint8_t family() const { return this->rom_ & 0xFF; }
+  /// Resolution the configuration register on the device currently asks for.
+  uint8_t resolution() const;
+  /// TH, TL and configuration register as stored in EEPROM.
+  const uint8_t *eeprom() const { return this->eeprom_; }
+  const Stats &stats() const { return this->stats_; }
+
+  /// What the next conversion measures.
+  float temperature;
+  bool parasite{false};
+  /// Unplugged devices neither answer a reset nor take part in time slots.
+  bool connected{true};
+  /// Corrupt the next `crc_faults` scratch pads read.
+  uint16_t crc_faults{0};
+  /// Share of the worst case time a conversion really takes.
+  float conversion_speed{0.8f};
+  /// EEPROM write time of COPY SCRATCHPAD, the datasheet guarantees 10 ms.
+  uint32_t copy_us{5000};
+
+  // Line side, driven by OneWireChannel
+  void attach(OneWireChannel *channel) { this->channel_ = channel; }
+  /// Reset pulse, true for a presence pulse.
+  bool reset(uint64_t now);
+  /// One time slot in which the master writes `bit` (1 for a read slot), returns
+  /// the level this device leaves on the line.
+  bool slot(bool bit, uint64_t now);
+  /// The strong pullup of the channel ended.
+  void pullup_released(uint64_t now);
+
+ protected:
+  enum class Mode : uint8_t {
+    IDLE,
+    ROM,
+    MATCH,
+    SEARCH,
+    SEND,
+    FUNCTION,
+    WRITE,
+    BUSY,
+    POWER,
+  };
+
+  bool can_resume_() const { return this->family() == DS28EA00; }
+  /// Finish a conversion or EEPROM write whose time has come.
+  void finish_(uint64_t now);
+  void receive_(uint8_t byte, uint64_t now);
+  void rom_command_(uint8_t command);
+  void function_command_(uint8_t command, uint64_t now);
+  void send_(const uint8_t *data, uint8_t len);
+  void fill_scratch_pad_(uint8_t *scratch_pad) const;
+  void store_temperature_();
+  /// Power on reset, as after a brownout.
+  void power_on_();
+
+  OneWireChannel *channel_{nullptr};
+  uint64_t rom_;
+  uint8_t eeprom_[3];
+  Stats stats_{};
+
+  // Scratch pad: temperature register, TH, TL, configuration
+  int16_t temp_raw_;
+  uint8_t count_remain_{0x0C};
+  uint8_t registers_[3];
+  bool alarm_{false};
+
+  Mode mode_{Mode::IDLE};
+  uint8_t rx_byte_{0};
+  uint8_t rx_bits_{0};
+  uint8_t rx_count_{0};
+  uint8_t tx_[9];
+  uint8_t tx_len_{0};
+  uint16_t tx_bit_{0};
+  uint8_t search_bit_{0};
+  uint8_t search_phase_{0};
+  uint64_t match_{0};
+  /// RESUME flag: the last ROM command selected this device.
+  bool resume_{false};
+
+  bool converting_{false};
+  bool copying_{false};
+  uint64_t busy_until_{0};
+};
+
+/// One 1-Wire line with the devices on it, wired-AND.
+class OneWireChannel {
+ public:
+  void attach(DS18x20 *device);
+  void detach(DS18x20 *device);
+  const std::vector<DS18x20 *> &devices() const { return this->devices_; }
+
+  /// A short pulls the line low: no presence, every slot reads 0.
+  bool shorted{false};
+  /// Presence pulses get lost, e.g. on a long line, devices still work otherwise.
+  bool presence_lost{false};
+
+  /// Reset pulse, true if any device answered with a presence pulse.
+  bool reset(uint64_t now);
+  bool slot(bool bit, uint64_t now);
+  void write_byte(uint8_t byte, uint64_t now);
+  uint8_t read_byte(uint64_t now);
+
+  /// The DS2482 switches to the strong pullup right after the current slot or byte.
+  void set_pullup_armed(bool armed) { this->pullup_armed_ = armed; }
+  bool pullup_armed() const { return this->pullup_armed_; }
+  void release_pullup(uint64_t now);
+
+  uint32_t resets() const { return this->resets_; }
+
+ protected:
+  std::vector<DS18x20 *> devices_;
+  bool pullup_armed_{false};
+  uint32_t resets_{0};
+};
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,82 @@
+#include "sim_bus.h"
+
+#include <vector>
+
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace sim {
+
+uint32_t SimBus::transfer_us(size_t len) const {
+  // Start and stop take about one clock each
+  uint64_t clocks = 9 * (len + 1) + 2;
+  return (clocks * 1000000 + this->frequency_ - 1) / this->frequency_;
+}
+
+I2CTarget *SimBus::begin_(uint8_t address, size_t len) {
+  // A write without stop and the read after it are one transaction
+  bool continued = this->held_.exchange(-1) == address;
+  if (!continued) {
+    if (this->active_.fetch_add(1) != 0)
+      this->overlaps_++;
+    this->transfers_++;
+    if (this->monitor_)
+      this->monitor_(address);
+  }
+  this->bytes_ += len;
+  uint32_t us = this->transfer_us(len);
+  this->busy_us_ += us;
+  // The bus is held for the whole transfer, on the real clock as well
+  delayMicroseconds(us);
+
+  auto it = this->targets_.find(address);
+  if (it == this->targets_.end())
+    return nullptr;
+  if (!continued)
+    this->per_address_[address & 0x7F]++;
+  return it->second;
+}
+
+void SimBus::end_(uint8_t address, bool stop) {
+  if (stop)
+    this->active_--;
+  else
+    this->held_ = address;
+}
+
+uint32_t SimBus::transfers(uint8_t address) const { return this->per_address_[address & 0x7F]; }
+
+i2c::ErrorCode SimBus::readv(uint8_t address, i2c::ReadBuffer *buffers, size_t cnt) {
+  size_t len = 0;
+  for (size_t i = 0; i < cnt; i++)
+    len += buffers[i].len;
+
+  I2CTarget *target = this->begin_(address, len);
+  std::vector<uint8_t> data(len);
+  bool ack = target != nullptr && target->i2c_read(data.data(), len);
+  this->end_(address, true);
+  if (!ack)
+    return i2c::ERROR_NOT_ACKNOWLEDGED;
+
+  size_t pos = 0;
+  for (size_t i = 0; i < cnt; i++) {
+    for (size_t j = 0; j < buffers[i].len; j++)
+      buffers[i].data[j] = data[pos++];
+  }
+  return i2c::ERROR_OK;
+}
+
+i2c::ErrorCode SimBus::writev(uint8_t address, i2c::WriteBuffer *buffers, size_t cnt, bool stop) {
+  std::vector<uint8_t> data;
+  for (size_t i = 0; i < cnt; i++)
+    data.insert(data.end(), buffers[i].data, buffers[i].data + buffers[i].len);
+
+  I2CTarget *target = this->begin_(address, data.size());
+  bool ack = target != nullptr && target->i2c_write(data.data(), data.size());
+  // A NACK ends the transaction with a stop
+  this->end_(address, stop || !ack);
+  return ack ? i2c::ERROR_OK : i2c::ERROR_NOT_ACKNOWLEDGED;
+}
+
+}  // namespace sim
+}  // namespace esphome
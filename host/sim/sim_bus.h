@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+
+#include "esphome/components/i2c/i2c.h"
+
+namespace esphome {
+namespace sim {
+
+/// A device model on the simulated I2C bus.
+class I2CTarget {
+ public:
+  virtual ~I2CTarget() = default;
+  /// One write transfer, false to NACK it.
+  virtual bool i2c_write(const uint8_t *data, size_t len) = 0;
+  /// One read transfer, false to NACK it.
+  virtual bool i2c_read(uint8_t *data, size_t len) = 0;
+};
+
+/// I2C bus routing transfers to the device models by address.
+///
+/// Every transfer advances the clock by the time it takes on the wire, so the
+/// time the code under test spends on the bus shows up in micros(). Transfers
+/// that overlap, from threads not serialized against each other, are counted.
+class SimBus : public i2c::I2CBus {
+ public:
+  void attach(uint8_t address, I2CTarget *target) { this->targets_[address] = target; }
+  void set_frequency(uint32_t hz) { this->frequency_ = hz; }
+  /// Start, address byte, `len` bytes and stop, 9 clocks per byte.
+  uint32_t transfer_us(size_t len) const;
+
+  i2c::ErrorCode readv(uint8_t address, i2c::ReadBuffer *buffers, size_t cnt) override;
+  i2c::ErrorCode writev(uint8_t address, i2c::WriteBuffer *buffers, size_t cnt, bool stop) override;
+
+  /// Transactions, a write without stop and the read after it count once.
+  uint32_t transfers() const { return this->transfers_; }
+  /// Transfers addressed to one device.
+  uint32_t transfers(uint8_t address) const;
+  uint32_t payload_bytes() const { return this->bytes_; }
+  uint64_t busy_us() const { return this->busy_us_; }
+  /// Transfers started while another one was still on the bus.
+  uint32_t overlaps() const { return this->overlaps_; }
+  /// Called with the address of every transaction as it starts, nullptr for none.
+  void set_monitor(std::function<void(uint8_t address)> monitor) { this->monitor_ = std::move(monitor); }
+
+ protected:
+  I2CTarget *begin_(uint8_t address, size_t len);
+  void end_(uint8_t address, bool stop);
+
+  std::map<uint8_t, I2CTarget *> targets_;
+  std::function<void(uint8_t address)> monitor_;
+  std::atomic<uint32_t> per_address_[128]{};
+  uint32_t frequency_{400000};
+  std::atomic<uint32_t> transfers_{0};
+  std::atomic<uint32_t> bytes_{0};
+  std::atomic<uint64_t> busy_us_{0};
+  std::atomic<uint32_t> overlaps_{0};
+  std::atomic<uint8_t> active_{0};
+  /// Address of a transaction held open by a write without stop, -1 for none.
+  std::atomic<int> held_{-1};
+};
+
+}  // namespace sim
+}  // namespace esphome
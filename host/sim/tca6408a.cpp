@@ -0,0 +1,30 @@
+#include "tca6408a.h"
+
+namespace esphome {
+namespace sim {
+
+bool TCA6408A::i2c_write(const uint8_t *data, size_t len) {
+  if (len == 0 || data[0] > 3)
+    return false;
+  this->pointer_ = data[0];
+  // The pointer does not advance, every byte goes to the same register
+  for (size_t i = 1; i < len; i++) {
+    if (this->pointer_ != 0)
+      this->registers_[this->pointer_] = data[i];
+  }
+  return true;
+}
+
+bool TCA6408A::i2c_read(uint8_t *data, size_t len) {
+  uint8_t config = this->registers_[3];
+  // Output pins read back what they drive
+  this->registers_[0] = ((this->inputs & config) | (this->registers_[1] & ~config)) ^ this->registers_[2];
+  for (size_t i = 0; i < len; i++)
+    data[i] = this->registers_[this->pointer_];
+  if (this->pointer_ == 0)
+    this->input_reads_++;
+  return true;
+}
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sim_bus.h"
+
+namespace esphome {
+namespace sim {
+
+/// TCA6408A 8 bit I/O expander: input, output, polarity and configuration register.
+class TCA6408A : public I2CTarget {
+ public:
+  /// Level driven onto the pins configured as inputs.
+  uint8_t inputs{0};
+  uint8_t output() const { return this->registers_[1]; }
+  /// 1 for an input pin.
+  uint8_t config() const { return this->registers_[3]; }
+  uint32_t input_reads() const { return this->input_reads_; }
+
+  bool i2c_write(const uint8_t *data, size_t len) override;
+  bool i2c_read(uint8_t *data, size_t len) override;
+
+ protected:
+  uint8_t registers_[4]{0xFF, 0xFF, 0x00, 0xFF};
+  uint8_t pointer_{0};
+  uint32_t input_reads_{0};
+};
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,125 @@
+#include "harness.h"
+
+#include <algorithm>
+#include <string>
+
+#include "esphome/core/helpers.h"
+#include "esphome/host/clock.h"
+
+namespace esphome {
+namespace sim {
+
+/// ESPHome's default main loop interval.
+static const uint32_t LOOP_INTERVAL_US = 16000;
+
+void LoopRunner::add(Component *component) { this->entries_.push_back({component, nullptr, 0}); }
+void LoopRunner::add(PollingComponent *component) { this->entries_.push_back({component, component, 0}); }
+
+void LoopRunner::setup() {
+  for (auto &entry : this->entries_) {
+    entry.component->setup();
+    entry.next_update = host::now_us();
+  }
+}
+
+void LoopRunner::iterate_() {
+  uint64_t start = host::now_us();
+  for (auto &entry : this->entries_) {
+    if (entry.polling != nullptr && host::now_us() >= entry.next_update) {
+      uint64_t before = host::now_us();
+      entry.polling->update();
+      this->call_us_.push_back(host::now_us() - before);
+      entry.next_update += uint64_t(entry.polling->get_update_interval()) * 1000;
+    }
+    uint64_t before = host::now_us();
+    entry.component->loop();
+    this->call_us_.push_back(host::now_us() - before);
+  }
+  this->iterations_++;
+
+  uint64_t elapsed = host::now_us() - start;
+  // Sleeps on the real clock
+  if (HighFrequencyLoopRequester::is_high_frequency()) {
+    delayMicroseconds(this->overhead_us_);
+  } else if (elapsed < LOOP_INTERVAL_US) {
+    delayMicroseconds(LOOP_INTERVAL_US - elapsed);
+  }
+}
+
+void LoopRunner::run_for(uint32_t ms) {
+  uint64_t end = host::now_us() + uint64_t(ms) * 1000;
+  while (host::now_us() < end)
+    this->iterate_();
+}
+
+bool LoopRunner::run_until(const std::function<bool()> &done, uint32_t timeout_ms) {
+  uint64_t end = host::now_us() + uint64_t(timeout_ms) * 1000;
+  while (!done()) {
+    if (host::now_us() >= end)
+      return false;
+    this->iterate_();
+  }
+  return true;
+}
+
+uint32_t LoopRunner::max_call_us() const {
+  return this->call_us_.empty() ? 0 : *std::max_element(this->call_us_.begin(), this->call_us_.end());
+}
+
+uint32_t LoopRunner::call_percentile(uint8_t percent) const {
+  if (this->call_us_.empty())
+    return 0;
+  std::vector<uint32_t> sorted = this->call_us_;
+  std::sort(sorted.begin(), sorted.end());
+  size_t rank = (sorted.size() * percent + 99) / 100;
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+void LoopRunner::reset_stats() {
+  this->call_us_.clear();
+  this->iterations_ = 0;
+}
+
+SimBus *new_bus() { return new SimBus(); }  // NOLINT(cppcoreguidelines-owning-memory)
+
+dallas::DallasComponent *new_hub(SimBus *bus, DS2482 *chip, uint8_t address, uint8_t channels) {
+  bus->attach(address, chip);
+  auto *hub = new dallas::DallasComponent();  // NOLINT(cppcoreguidelines-owning-memory)
+  hub->set_i2c_bus(bus);
+  hub->set_i2c_address(address);
+  hub->setChannelCount(channels);
+  hub->set_update_interval(10000);
+  return hub;
+}
+
+dallas::DallasTemperatureSensor *new_sensor(dallas::DallasComponent *hub, const DS18x20 &device, uint8_t channel,
+                                            uint8_t resolution) {
+  auto *sensor = new dallas::DallasTemperatureSensor();  // NOLINT(cppcoreguidelines-owning-memory)
+  sensor->set_name("0x" + format_hex(device.rom()));
+  sensor->set_parent(hub);
+  sensor->set_address(device.rom());
+  sensor->set_channel(channel);
+  sensor->set_resolution(resolution);
+  hub->register_sensor(sensor);
+  return sensor;
+}
+
+dallas::DallasTemperatureSensor *new_index_sensor(dallas::DallasComponent *hub, uint8_t index, uint8_t resolution) {
+  auto *sensor = new dallas::DallasTemperatureSensor();  // NOLINT(cppcoreguidelines-owning-memory)
+  sensor->set_name("index " + std::to_string(index));
+  sensor->set_parent(hub);
+  sensor->set_index(index);
+  sensor->set_resolution(resolution);
+  hub->register_sensor(sensor);
+  return sensor;
+}
+
+uint32_t total(const std::vector<DS18x20 *> &devices, uint32_t DS18x20::Stats::*field) {
+  uint32_t sum = 0;
+  for (auto *device : devices)
+    sum += device->stats().*field;
+  return sum;
+}
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/components/dallas_ds2482/dallas_component.h"
+#include "ds2482.h"
+#include "sim_bus.h"
+
+namespace esphome {
+namespace sim {
+
+/// Runs components the way the ESPHome main loop does, on the simulated clock.
+///
+/// An iteration calls every loop() and the update() of polling components that
+/// are due, then idles to the 16 ms loop interval unless a component asked for
+/// a high frequency loop. The simulated time each call takes is its blocking.
+class LoopRunner {
+ public:
+  void add(Component *component);
+  void add(PollingComponent *component);
+  /// Call setup() of all components, in the order added.
+  void setup();
+  /// Run the main loop for `ms` of simulated time.
+  void run_for(uint32_t ms);
+  /// Run until `done` holds, false if `timeout_ms` passed first.
+  bool run_until(const std::function<bool()> &done, uint32_t timeout_ms);
+  /// Time the rest of a high frequency loop iteration takes, other components included.
+  void set_loop_overhead_us(uint32_t us) { this->overhead_us_ = us; }
+
+  /// Duration of every loop() and update() call since the last reset_stats(), µs.
+  const std::vector<uint32_t> &call_us() const { return this->call_us_; }
+  uint32_t max_call_us() const;
+  /// Percentile of call_us().
+  uint32_t call_percentile(uint8_t percent) const;
+  uint32_t iterations() const { return this->iterations_; }
+  void reset_stats();
+
+ protected:
+  struct Entry {
+    Component *component;
+    PollingComponent *polling;
+    uint64_t next_update;
+  };
+  void iterate_();
+
+  std::vector<Entry> entries_;
+  std::vector<uint32_t> call_us_;
+  uint32_t overhead_us_{100};
+  uint32_t iterations_{0};
+};
+
+/// I2C bus for a test. Never freed: hub groups and arbiters are kept per bus for
+/// the whole process, a new bus at the address of a freed one would find them.
+SimBus *new_bus();
+
+/// A hub on `bus` at `address` driving `chip`.
+dallas::DallasComponent *new_hub(SimBus *bus, DS2482 *chip, uint8_t address = 0x18, uint8_t channels = 8);
+
+/// A sensor bound to a device by address.
+dallas::DallasTemperatureSensor *new_sensor(dallas::DallasComponent *hub, const DS18x20 &device, uint8_t channel,
+                                            uint8_t resolution = 12);
+
+/// A sensor bound to the `index`th device found.
+dallas::DallasTemperatureSensor *new_index_sensor(dallas::DallasComponent *hub, uint8_t index, uint8_t resolution = 12);
+
+/// Sum of a DS18x20 statistic over devices.
+uint32_t total(const std::vector<DS18x20 *> &devices, uint32_t DS18x20::Stats::*field);
+
+}  // namespace sim
+}  // namespace esphome
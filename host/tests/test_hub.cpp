@@ -0,0 +1,778 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "esphome/core/hal.h"
+#include "esphome/components/dallas_ds2482/automation.h"
+#include "esphome/host/log.h"
+#include "esphome/host/preferences.h"
+#include "ds2482.h"
+#include "harness.h"
+
+namespace esphome {
+namespace sim {
+
+using dallas::DallasComponent;
+using dallas::DallasTemperatureSensor;
+
+// The hub component on the simulated main loop
+
+class HubTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    host::preferences().erase();
+    host::preferences().set_flash_budget(0);
+    host::reset_log_counts();
+  }
+
+  DS18x20 *add(uint8_t channel, uint8_t family, uint64_t serial, float temperature = 21.5f) {
+    this->devices_.push_back(std::make_unique<DS18x20>(family, serial, temperature));
+    this->chip_.channel(channel).attach(this->devices_.back().get());
+    return this->devices_.back().get();
+  }
+
+  std::vector<DS18x20 *> devices() const {
+    std::vector<DS18x20 *> devices;
+    for (auto &device : this->devices_)
+      devices.push_back(device.get());
+    return devices;
+  }
+
+  DallasComponent *hub() {
+    this->hub_ = new_hub(this->bus_, &this->chip_);
+    this->runner_.add(this->hub_);
+    return this->hub_;
+  }
+
+  /// A new hub on a new bus, the same chip and flash: a reboot.
+  DallasComponent *reboot() {
+    this->bus_ = new_bus();
+    this->runner_ = LoopRunner();
+    return this->hub();
+  }
+
+  /// Run until every sensor published `publishes` values in total.
+  bool run_publishes(const std::vector<DallasTemperatureSensor *> &sensors, uint32_t publishes,
+                     uint32_t timeout_ms = 30000) {
+    return this->runner_.run_until(
+        [&]() {
+          for (auto *sensor : sensors) {
+            if (sensor->get_publishes() < publishes)
+              return false;
+          }
+          return true;
+        },
+        timeout_ms);
+  }
+
+  SimBus *bus_{new_bus()};
+  DS2482 chip_;
+  LoopRunner runner_;
+  DallasComponent *hub_{nullptr};
+  std::vector<std::unique_ptr<DS18x20>> devices_;
+};
+
+TEST_F(HubTest, SweepPublishesEverySensor) {
+  DS18x20 *a = this->add(0, DS18x20::DS18B20, 1, 20.5f);
+  DS18x20 *b = this->add(0, DS18x20::DS1822, 2, -3.25f);
+  DS18x20 *c = this->add(3, DS18x20::DS18S20, 3, 45.5f);
+  this->add(7, DS18x20::DS1825, 4, 99.0f);
+  auto *hub = this->hub();
+  auto *sa = new_sensor(hub, *a, 0);
+  auto *sb = new_sensor(hub, *b, 0, 10);
+  auto *sc = new_sensor(hub, *c, 3);
+  // Fourth device in search order
+  auto *sd = new_index_sensor(hub, 3);
+  this->runner_.setup();
+  EXPECT_FALSE(hub->status_has_error());
+
+  ASSERT_TRUE(this->run_publishes({sa, sb, sc, sd}, 2));
+  EXPECT_FLOAT_EQ(sa->get_state(), 20.5f);
+  EXPECT_FLOAT_EQ(sb->get_state(), -3.25f);
+  EXPECT_NEAR(sc->get_state(), 45.5f, 0.25f);
+  EXPECT_FLOAT_EQ(sd->get_state(), 99.0f);
+  EXPECT_EQ(b->resolution(), 10);
+
+  EXPECT_EQ(this->chip_.stats().busy_violations, 0u);
+  EXPECT_EQ(this->chip_.stats().bad_transfers, 0u);
+  EXPECT_EQ(total(this->devices(), &DS18x20::Stats::interrupted_copies), 0u);
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 0u);
+}
+
+TEST_F(HubTest, FastSensorKeepsItsRateNextToASlowChannel) {
+  DS18x20 *fast = this->add(0, DS18x20::DS18B20, 1, 20.5f);
+  DS18x20 *slow = this->add(1, DS18x20::DS18B20, 2, 30.5f);
+  auto *hub = this->hub();
+  hub->set_update_interval(1000);
+  auto *sf = new_sensor(hub, *fast, 0, 9);
+  sf->set_update_interval(100);
+  auto *ss = new_sensor(hub, *slow, 1, 12);
+  this->runner_.setup();
+  this->runner_.run_for(1000);
+
+  // The 12-bit conversions on channel 1 take 750 ms of every second, the fast
+  // sensor converts on channel 0 meanwhile. A 9-bit cycle is 94 ms of conversion,
+  // 15 ms of reading and up to 16 ms of loop latency, so it can't keep 100 ms:
+  // about 80 of 100 is what it makes on a hub of its own.
+  uint32_t fast_start = sf->get_publishes();
+  uint32_t slow_start = ss->get_publishes();
+  this->runner_.run_for(10000);
+  EXPECT_GE(sf->get_publishes() - fast_start, 75u);
+  EXPECT_GE(ss->get_publishes() - slow_start, 9u);
+  EXPECT_FLOAT_EQ(sf->get_state(), 20.5f);
+  EXPECT_FLOAT_EQ(ss->get_state(), 30.5f);
+  EXPECT_EQ(this->chip_.stats().busy_violations, 0u);
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 0u);
+}
+
+TEST_F(HubTest, ContinuousModeConvertsEachChannelAgainWhenRead) {
+  DS18x20 *fast = this->add(0, DS18x20::DS18B20, 1, 20.5f);
+  DS18x20 *slow = this->add(1, DS18x20::DS18B20, 2, 30.5f);
+  auto *hub = this->hub();
+  hub->set_update_interval(1000);
+  hub->set_continuous(true);
+  auto *sf = new_sensor(hub, *fast, 0, 9);
+  auto *ss = new_sensor(hub, *slow, 1, 12);
+  this->runner_.setup();
+  this->runner_.run_for(1000);
+
+  // Channel 0 restarts every ~115 ms of 9-bit conversion and read, not after the
+  // 750 ms of channel 1; publishing stays at one value per update
+  uint32_t fast_conversions = fast->stats().conversions;
+  uint32_t slow_conversions = slow->stats().conversions;
+  uint32_t fast_publishes = sf->get_publishes();
+  uint32_t slow_publishes = ss->get_publishes();
+  this->runner_.run_for(5000);
+  EXPECT_GE(fast->stats().conversions - fast_conversions, 35u);
+  EXPECT_GE(slow->stats().conversions - slow_conversions, 5u);
+  EXPECT_LE(slow->stats().conversions - slow_conversions, 7u);
+  EXPECT_NEAR(double(sf->get_publishes() - fast_publishes), 5.0, 1.0);
+  EXPECT_NEAR(double(ss->get_publishes() - slow_publishes), 5.0, 1.0);
+  EXPECT_FLOAT_EQ(sf->get_latest(), 20.5f);
+  EXPECT_FLOAT_EQ(ss->get_latest(), 30.5f);
+
+  // A change on the fast channel shows in its latest value long before the slow one converts again
+  fast->temperature = 22.0f;
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sf->get_latest() == 22.0f; }, 300));
+  EXPECT_FLOAT_EQ(ss->get_latest(), 30.5f);
+  EXPECT_EQ(this->chip_.stats().busy_violations, 0u);
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 0u);
+}
+
+TEST_F(HubTest, PolledConversionIsReadWhenTheDeviceIsDone) {
+  DS18x20 *device = this->add(2, DS18x20::DS18B20, 1, 22.5f);
+  // Done after 300 ms of the 750 ms worst case
+  device->conversion_speed = 0.4f;
+  auto *hub = this->hub();
+  hub->set_update_interval(1000);
+  hub->set_conversion_poll_interval(20);
+  auto *sensor = new_sensor(hub, *device, 2);
+  this->runner_.setup();
+
+  // Unknown conversion time: the polls start right away
+  const uint32_t start = millis();
+  uint32_t bits = this->chip_.stats().bits;
+  ASSERT_TRUE(this->run_publishes({sensor}, 1, 1000));
+  uint32_t first_ms = millis() - start;
+  uint32_t first_bits = this->chip_.stats().bits - bits;
+  EXPECT_GE(first_ms, 300u);
+  EXPECT_LT(first_ms, 400u);
+  EXPECT_GE(first_bits, 10u);
+
+  // Learned: the first poll comes shortly before 300 ms
+  bits = this->chip_.stats().bits;
+  ASSERT_TRUE(this->run_publishes({sensor}, 2, 2000));
+  uint32_t second_ms = millis() - start - 1000;
+  uint32_t second_bits = this->chip_.stats().bits - bits;
+  EXPECT_GE(second_ms, 300u);
+  EXPECT_LT(second_ms, 400u);
+  EXPECT_LE(second_bits, 4u);
+  EXPECT_FLOAT_EQ(sensor->get_state(), 22.5f);
+  EXPECT_EQ(this->chip_.stats().busy_violations, 0u);
+}
+
+TEST_F(HubTest, AlarmSearchReadsOnlyTrippedSensors) {
+  DS18x20 *hot = this->add(3, DS18x20::DS18B20, 1, 20.0f);
+  DS18x20 *calm = this->add(3, DS18x20::DS18B20, 2, 20.0f);
+  auto *hub = this->hub();
+  hub->set_update_interval(1000);
+  hub->set_alarm_search(true);
+  auto *sh = new_sensor(hub, *hot, 3);
+  sh->set_alarm_high(10);
+  sh->set_alarm_low(-10);
+  auto *sc = new_sensor(hub, *calm, 3);
+  sc->set_alarm_high(50);
+  sc->set_alarm_low(-10);
+  this->runner_.setup();
+  // Read once, the search only tells which of them changed
+  ASSERT_TRUE(this->run_publishes({sh, sc}, 1));
+
+  uint32_t hot_reads = hot->stats().scratch_pad_reads;
+  uint32_t calm_reads = calm->stats().scratch_pad_reads;
+  uint32_t calm_publishes = sc->get_publishes();
+  this->runner_.run_for(20000);
+  EXPECT_NEAR(double(hot->stats().scratch_pad_reads - hot_reads), 20.0, 1.0);
+  // Not in alarm, read and published on every 10th sweep only
+  EXPECT_NEAR(double(calm->stats().scratch_pad_reads - calm_reads), 2.0, 1.0);
+  EXPECT_EQ(sc->get_publishes() - calm_publishes, calm->stats().scratch_pad_reads - calm_reads);
+
+  calm->temperature = 60.0f;
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sc->get_state() == 60.0f; }, 2500));
+  EXPECT_FLOAT_EQ(sh->get_state(), 20.0f);
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 0u);
+}
+
+TEST_F(HubTest, HubsOnOneBusOverlapTheirSweeps) {
+  DS2482 second;
+  auto *hub = this->hub();
+  auto *other = new_hub(this->bus_, &second, 0x19);
+  this->runner_.add(other);
+  std::vector<DallasTemperatureSensor *> sensors;
+  for (uint8_t i = 0; i < 4; i++) {
+    DS18x20 *device = this->add(i, DS18x20::DS18B20, i + 1, 20.0f + i);
+    sensors.push_back(new_sensor(hub, *device, i));
+    this->devices_.push_back(std::make_unique<DS18x20>(DS18x20::DS18B20, i + 0x11, 30.0f + i));
+    second.channel(i).attach(this->devices_.back().get());
+    sensors.push_back(new_sensor(other, *this->devices_.back(), i));
+  }
+  hub->set_update_interval(1000);
+  other->set_update_interval(1000);
+  sensor::Sensor throughput;
+  hub->set_diagnostic_sensor(dallas::DIAGNOSTIC_BUS_THROUGHPUT, &throughput);
+  this->runner_.setup();
+  this->runner_.reset_stats();
+
+  // One after the other would take two 750 ms conversions
+  ASSERT_TRUE(this->run_publishes(sensors, 1, 1000));
+  for (uint8_t i = 0; i < 4; i++) {
+    EXPECT_FLOAT_EQ(sensors[2 * i]->get_state(), 20.0f + i);
+    EXPECT_FLOAT_EQ(sensors[2 * i + 1]->get_state(), 30.0f + i);
+  }
+
+  // 8 sensors read per second, counted across the bus
+  this->runner_.run_for(12000);
+  EXPECT_NEAR(throughput.get_state(), 8.0f, 0.5f);
+  // Each loop() slice ends after 1 ms, past it by at most one transfer
+  EXPECT_LT(this->runner_.max_call_us(), 1500u);
+  EXPECT_EQ(this->chip_.stats().busy_violations + second.stats().busy_violations, 0u);
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 0u);
+}
+
+TEST_F(HubTest, ConvertingHubStepsFirstOnASharedBus) {
+  DS2482 second;
+  auto *hub = this->hub();
+  auto *other = new_hub(this->bus_, &second, 0x19);
+  this->runner_.add(other);
+  std::vector<DallasTemperatureSensor *> sensors;
+  for (uint8_t i = 0; i < 8; i++) {
+    DS18x20 *device = this->add(0, DS18x20::DS18B20, i + 1);
+    sensors.push_back(new_sensor(hub, *device, 0));
+  }
+  for (uint8_t i = 0; i < 4; i++) {
+    this->devices_.push_back(std::make_unique<DS18x20>(DS18x20::DS18B20, i + 0x11, 30.0f));
+    second.channel(i).attach(this->devices_.back().get());
+    new_sensor(other, *this->devices_.back(), i);
+  }
+  other->set_update_interval(100000);
+  this->runner_.setup();
+
+  // The first hub reads its channel when the second one is asked to convert
+  ASSERT_TRUE(this->run_publishes(sensors, 1));
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sensors[0]->get_publishes() == 2; }, 11000));
+  ASSERT_LT(sensors[7]->get_publishes(), 2u);
+  other->update();
+
+  // The slices take turns with the hub they start with, but a conversion goes first
+  // in each. The first step of the new sweep only queues its transaction.
+  hub->loop();
+  std::vector<uint8_t> addresses;
+  this->bus_->set_monitor([&](uint8_t address) { addresses.push_back(address); });
+  for (uint8_t slice = 0; slice < 3; slice++) {
+    addresses.clear();
+    hub->loop();
+    ASSERT_GE(addresses.size(), 2u);
+    EXPECT_EQ(addresses[0], 0x19);
+    EXPECT_NE(std::count(addresses.begin(), addresses.end(), 0x18), 0);
+  }
+  this->bus_->set_monitor(nullptr);
+}
+
+TEST_F(HubTest, ParasiteChannelConvertsOnTheStrongPullup) {
+  DS18x20 *a = this->add(2, DS18x20::DS18B20, 1, 12.0f);
+  DS18x20 *b = this->add(2, DS18x20::DS18B20, 2, 13.0f);
+  a->parasite = b->parasite = true;
+  DS18x20 *c = this->add(4, DS18x20::DS18B20, 3, 14.0f);
+  auto *hub = this->hub();
+  auto *sa = new_sensor(hub, *a, 2, 11);
+  auto *sb = new_sensor(hub, *b, 2);
+  auto *sc = new_sensor(hub, *c, 4);
+  this->runner_.setup();
+
+  ASSERT_TRUE(this->run_publishes({sa, sb, sc}, 3));
+  EXPECT_FLOAT_EQ(sa->get_state(), 12.0f);
+  EXPECT_FLOAT_EQ(sb->get_state(), 13.0f);
+  EXPECT_FLOAT_EQ(sc->get_state(), 14.0f);
+  EXPECT_EQ(a->resolution(), 11);
+  EXPECT_EQ(total(this->devices(), &DS18x20::Stats::brownouts), 0u);
+  EXPECT_EQ(this->chip_.stats().busy_violations, 0u);
+  // Released by a queued step once the conversion is done
+  this->runner_.run_for(100);
+  EXPECT_FALSE(this->chip_.pullup_active());
+  EXPECT_EQ(this->chip_.config() & DS2482_CONFIG_SPU, 0);
+  EXPECT_EQ(this->chip_.stats().bad_transfers, 0u);
+}
+
+TEST_F(HubTest, RescanChecksThePowerSupplyWithoutBlocking) {
+  DS18x20 *a = this->add(2, DS18x20::DS18B20, 1, 12.0f);
+  DS18x20 *late = this->add(2, DS18x20::DS18B20, 2, 13.0f);
+  late->parasite = true;
+  late->connected = false;
+  auto *hub = this->hub();
+  hub->set_rescan(true);
+  auto *sa = new_sensor(hub, *a, 2);
+  auto *sl = new_sensor(hub, *late, 2);
+  this->runner_.setup();
+  this->runner_.reset_stats();
+
+  late->connected = true;
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sl->has_state() && !std::isnan(sl->get_state()); }, 60000));
+  // Converting without the strong pullup until the rescan found it
+  uint32_t brownouts = late->stats().brownouts;
+  ASSERT_TRUE(this->run_publishes({sa, sl}, sl->get_publishes() + 2));
+  EXPECT_FLOAT_EQ(sa->get_state(), 12.0f);
+  EXPECT_FLOAT_EQ(sl->get_state(), 13.0f);
+  EXPECT_EQ(late->stats().brownouts, brownouts);
+  EXPECT_LT(this->runner_.max_call_us(), 2000u);
+}
+
+#ifdef DALLAS_DS2482_TRACE
+TEST_F(HubTest, DumpTraceActionLogsTheSweep) {
+  DS18x20 *a = this->add(1, DS18x20::DS18B20, 1);
+  auto *hub = this->hub();
+  auto *sa = new_sensor(hub, *a, 1);
+  this->runner_.setup();
+  ASSERT_TRUE(this->run_publishes({sa}, 1));
+
+  dallas::DumpTraceAction<> action;
+  action.set_parent(hub);
+  std::vector<std::string> lines;
+  host::capture_log(&lines);
+  action.play();
+  host::capture_log(nullptr);
+
+  // The ring is full after setup and a sweep, it ends with the scratch pad read
+  ASSERT_EQ(lines.size(), 1u + DALLAS_DS2482_TRACE);
+  EXPECT_EQ(lines.front(), "Trace, " + std::to_string(DALLAS_DS2482_TRACE) + " events:");
+  EXPECT_NE(lines.back().find(" ch 1 read "), std::string::npos) << lines.back();
+}
+#endif
+
+TEST_F(HubTest, SetupWaitsForEveryEepromWrite) {
+  DS18x20 *a = this->add(1, DS18x20::DS18B20, 1);
+  DS18x20 *b = this->add(1, DS18x20::DS18B20, 2);
+  DS18x20 *c = this->add(1, DS18x20::DS1822, 3);
+  auto *hub = this->hub();
+  new_sensor(hub, *a, 1, 9);
+  new_sensor(hub, *b, 1, 9);
+  new_sensor(hub, *c, 1, 11);
+  this->runner_.setup();
+
+  // A reset during a copy loses it, the next copy starts once the last one is done
+  EXPECT_EQ(total(this->devices(), &DS18x20::Stats::interrupted_copies), 0u);
+  EXPECT_EQ(total(this->devices(), &DS18x20::Stats::eeprom_writes), 3u);
+  EXPECT_EQ(a->eeprom()[2], 0x1F);
+  EXPECT_EQ(c->eeprom()[2], 0x5F);
+}
+
+TEST_F(HubTest, SetupResumesTheDeviceItConfigures) {
+  DS18x20 *resumable = this->add(2, DS18x20::DS28EA00, 1, 19.0f);
+  DS18x20 *other = this->add(2, DS18x20::DS18B20, 2, 20.0f);
+  auto *hub = this->hub();
+  auto *sr = new_sensor(hub, *resumable, 2, 10);
+  auto *so = new_sensor(hub, *other, 2, 10);
+  this->runner_.setup();
+
+  // Read, write and read back the configuration: one MATCH ROM, RESUME after it.
+  // The copies to EEPROM follow once the other device is configured, MATCH again.
+  EXPECT_EQ(resumable->resolution(), 10);
+  EXPECT_EQ(resumable->stats().matches, 2u);
+  EXPECT_EQ(resumable->stats().resumes, 2u);
+  EXPECT_EQ(resumable->stats().bad_commands, 0u);
+
+  // Sweeps convert with SKIP ROM and read the other device in between, each
+  // read selects it with MATCH ROM again
+  uint32_t matches = resumable->stats().matches;
+  uint32_t resumes = resumable->stats().resumes;
+  ASSERT_TRUE(this->run_publishes({sr, so}, 3));
+  EXPECT_EQ(resumable->stats().matches - matches, 3u);
+  EXPECT_EQ(resumable->stats().resumes, resumes);
+  EXPECT_FLOAT_EQ(sr->get_state(), 19.0f);
+  EXPECT_FLOAT_EQ(so->get_state(), 20.0f);
+  EXPECT_EQ(hub->getChannelStats(2).crcErrors, 0u);
+}
+
+TEST_F(HubTest, CrcErrorPublishesNanOnce) {
+  DS18x20 *a = this->add(1, DS18x20::DS18B20, 1, 22.0f);
+  auto *hub = this->hub();
+  auto *sa = new_sensor(hub, *a, 1);
+  this->runner_.setup();
+
+  a->crc_faults = 1;
+  ASSERT_TRUE(this->run_publishes({sa}, 1));
+  EXPECT_TRUE(std::isnan(sa->get_state()));
+  EXPECT_EQ(hub->getChannelStats(1).crcErrors, 1u);
+
+  ASSERT_TRUE(this->run_publishes({sa}, 2));
+  EXPECT_FLOAT_EQ(sa->get_state(), 22.0f);
+}
+
+TEST_F(HubTest, DiagnosticsPublishTheIncreasePerUpdate) {
+  DS18x20 *a = this->add(1, DS18x20::DS18B20, 1, 22.0f);
+  auto *hub = this->hub();
+  auto *sa = new_sensor(hub, *a, 1);
+  sensor::Sensor transactions, crc_errors, channel_errors;
+  hub->set_diagnostic_sensor(dallas::DIAGNOSTIC_I2C_TRANSACTIONS, &transactions);
+  hub->set_diagnostic_sensor(dallas::DIAGNOSTIC_CRC_ERRORS, &crc_errors);
+  hub->set_channel_error_sensor(1, &channel_errors);
+  this->runner_.setup();
+
+  // Every increase is published exactly once
+  float published = 0;
+  uint32_t counted = 0;
+  transactions.add_on_state_callback([&](float value) {
+    published += value;
+    counted = hub->getBusStats().writes + hub->getBusStats().reads;
+  });
+  ASSERT_TRUE(this->runner_.run_until([&]() { return transactions.get_publishes() >= 1; }, 20000));
+  EXPECT_FLOAT_EQ(crc_errors.get_state(), 0.0f);
+  // The first one includes the search and setup at boot
+  EXPECT_GT(transactions.get_state(), 0.0f);
+
+  a->crc_faults = 1;
+  ASSERT_TRUE(this->runner_.run_until([&]() { return transactions.get_publishes() >= 2; }, 20000));
+  EXPECT_FLOAT_EQ(crc_errors.get_state(), 1.0f);
+  EXPECT_FLOAT_EQ(channel_errors.get_state(), 1.0f);
+  float second = transactions.get_state();
+  ASSERT_TRUE(this->runner_.run_until([&]() { return transactions.get_publishes() >= 3; }, 20000));
+  EXPECT_FLOAT_EQ(crc_errors.get_state(), 0.0f);
+  EXPECT_FLOAT_EQ(channel_errors.get_state(), 0.0f);
+
+  // A steady sweep costs about the same every time
+  EXPECT_NEAR(transactions.get_state(), second, second / 10);
+  EXPECT_EQ(uint32_t(published), counted);
+  EXPECT_GE(sa->get_publishes(), 3u);
+}
+
+TEST_F(HubTest, ShortedChannelPublishesNan) {
+  DS18x20 *a = this->add(5, DS18x20::DS18B20, 1);
+  DS18x20 *b = this->add(6, DS18x20::DS18B20, 2, 17.0f);
+  auto *hub = this->hub();
+  auto *sa = new_sensor(hub, *a, 5);
+  auto *sb = new_sensor(hub, *b, 6);
+  this->runner_.setup();
+
+  this->chip_.channel(5).shorted = true;
+  ASSERT_TRUE(this->run_publishes({sa, sb}, 1));
+  EXPECT_TRUE(std::isnan(sa->get_state()));
+  EXPECT_FLOAT_EQ(sb->get_state(), 17.0f);
+  EXPECT_GT(hub->getChannelStats(5).shorts, 0u);
+  EXPECT_TRUE(hub->status_has_warning());
+
+  this->chip_.channel(5).shorted = false;
+  ASSERT_TRUE(this->run_publishes({sa, sb}, 2));
+  EXPECT_FLOAT_EQ(sa->get_state(), 21.5f);
+}
+
+TEST_F(HubTest, RescanFindsADeviceAddedLater) {
+  DS18x20 *a = this->add(0, DS18x20::DS18B20, 1, 10.0f);
+  DS18x20 *late = this->add(0, DS18x20::DS18B20, 2, 11.0f);
+  late->connected = false;
+  auto *hub = this->hub();
+  hub->set_rescan(true);
+  auto *sa = new_sensor(hub, *a, 0);
+  auto *sl = new_sensor(hub, *late, 0, 10);
+  this->runner_.setup();
+  this->runner_.reset_stats();
+
+  // Plugged in between sweeps, its first conversion is the next sweep's
+  ASSERT_TRUE(this->run_publishes({sa, sl}, 1));
+  EXPECT_TRUE(std::isnan(sl->get_state()));
+  late->connected = true;
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sl->has_state() && !std::isnan(sl->get_state()); }, 60000));
+  // Configured by the sweep whose rescan found it
+  ASSERT_TRUE(this->run_publishes({sa, sl}, sl->get_publishes() + 1));
+  EXPECT_FLOAT_EQ(sl->get_state(), 11.0f);
+  EXPECT_EQ(late->resolution(), 10);
+  EXPECT_EQ(late->stats().interrupted_copies, 0u);
+  EXPECT_LT(this->runner_.max_call_us(), 2000u);
+}
+
+TEST_F(HubTest, UnboundIndexSensorIsLeftOutOfTheSweeps) {
+  this->add(0, DS18x20::DS18B20, 1, 10.0f);
+  DS18x20 *late = this->add(0, DS18x20::DS18B20, 2, 10.0f);
+  late->connected = false;
+  auto *hub = this->hub();
+  hub->set_update_interval(1000);
+  hub->set_rescan(true);
+  auto *sa = new_index_sensor(hub, 0);
+  auto *sl = new_index_sensor(hub, 1);
+  this->runner_.setup();
+  host::reset_log_counts();
+
+  // No device to read yet, neither a NAN nor a CRC error every sweep
+  ASSERT_TRUE(this->run_publishes({sa}, 5));
+  EXPECT_EQ(sl->get_publishes(), 0u);
+  EXPECT_EQ(hub->getChannelStats(0).crcErrors, 0u);
+  EXPECT_EQ(late->stats().matches, 0u);
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 0u);
+
+  // Bound by the rescan that finds it, the index may move the other sensor
+  late->connected = true;
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sl->has_state() && !std::isnan(sl->get_state()); }, 10000));
+  EXPECT_FLOAT_EQ(sl->get_state(), 10.0f);
+  EXPECT_NE(sl->get_address(), sa->get_address());
+  EXPECT_EQ(hub->getChannelStats(0).crcErrors, 0u);
+}
+
+TEST_F(HubTest, ProbeFindsADeviceOnAnEmptyChannel) {
+  DS18x20 *a = this->add(0, DS18x20::DS18B20, 1, 10.0f);
+  DS18x20 *late = this->add(5, DS18x20::DS18B20, 2, 11.0f);
+  late->connected = false;
+  auto *hub = this->hub();
+  hub->set_update_interval(1000);
+  hub->set_probe_interval(1000);
+  auto *sa = new_sensor(hub, *a, 0);
+  auto *sl = new_index_sensor(hub, 1);
+  this->runner_.setup();
+
+  // Each probe is one reset on an empty channel, nothing answering is no error there
+  ASSERT_TRUE(this->run_publishes({sa}, 10));
+  uint32_t triplets = this->chip_.stats().triplets;
+  ASSERT_TRUE(this->run_publishes({sa}, 20));
+  EXPECT_EQ(this->chip_.stats().triplets, triplets);
+  for (uint8_t channel = 0; channel < 8; channel++)
+    EXPECT_EQ(hub->getChannelStats(channel).noPresence, 0u);
+  EXPECT_EQ(sl->get_publishes(), 0u);
+
+  // A presence pulse starts a search of the channel
+  late->connected = true;
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sl->has_state() && !std::isnan(sl->get_state()); }, 20000));
+  EXPECT_GT(this->chip_.stats().triplets, triplets);
+  EXPECT_FLOAT_EQ(sl->get_state(), 11.0f);
+  EXPECT_EQ(sl->get_channel(), 5);
+}
+
+TEST_F(HubTest, Ds2482_100SweepsAndRescansWithoutChannelSelects) {
+  // A DS2482-100 answers the channel select command as an invalid one
+  DS2482 chip(1);
+  DS18x20 a(DS18x20::DS18B20, 1, 10.0f);
+  DS18x20 late(DS18x20::DS18B20, 2, 11.0f);
+  late.connected = false;
+  chip.channel(0).attach(&a);
+  chip.channel(0).attach(&late);
+  auto *hub = new_hub(this->bus_, &chip, 0x18, 1);
+  this->runner_.add(hub);
+  hub->set_rescan(true);
+  auto *sa = new_sensor(hub, a, 0);
+  auto *sl = new_sensor(hub, late, 0, 10);
+  this->runner_.setup();
+
+  ASSERT_TRUE(this->run_publishes({sa, sl}, 1));
+  late.connected = true;
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sl->has_state() && !std::isnan(sl->get_state()); }, 60000));
+  ASSERT_TRUE(this->run_publishes({sa, sl}, sl->get_publishes() + 1));
+  EXPECT_FLOAT_EQ(sa->get_state(), 10.0f);
+  EXPECT_FLOAT_EQ(sl->get_state(), 11.0f);
+  EXPECT_EQ(chip.stats().channel_selects, 0u);
+  EXPECT_EQ(chip.stats().bad_transfers, 0u);
+  EXPECT_EQ(chip.stats().busy_violations, 0u);
+}
+
+TEST_F(HubTest, PersistedDevicesSkipTheSearch) {
+  DS18x20 *a = this->add(0, DS18x20::DS18B20, 1, 5.0f);
+  DS18x20 *b = this->add(3, DS18x20::DS18B20, 2, 6.0f);
+  auto *hub = this->hub();
+  hub->set_persist_devices(true);
+  new_sensor(hub, *a, 0, 9);
+  new_sensor(hub, *b, 3);
+  this->runner_.setup();
+  EXPECT_GT(this->chip_.stats().triplets, 0u);
+  EXPECT_EQ(host::preferences().saves(), 1u);
+
+  // Reboot: a new hub on a new bus, same chip and flash
+  uint32_t triplets = this->chip_.stats().triplets;
+  uint32_t writes = total(this->devices(), &DS18x20::Stats::eeprom_writes);
+  SimBus *bus = new_bus();
+  auto *rebooted = new_hub(bus, &this->chip_);
+  rebooted->set_persist_devices(true);
+  auto *sa = new_sensor(rebooted, *a, 0, 9);
+  auto *sb = new_sensor(rebooted, *b, 3);
+  LoopRunner runner;
+  runner.add(rebooted);
+  runner.setup();
+  EXPECT_EQ(this->chip_.stats().triplets, triplets);
+
+  ASSERT_TRUE(runner.run_until([&]() { return sa->get_publishes() >= 1 && sb->get_publishes() >= 1; }, 30000));
+  EXPECT_FLOAT_EQ(sa->get_state(), 5.0f);
+  EXPECT_FLOAT_EQ(sb->get_state(), 6.0f);
+  EXPECT_EQ(this->chip_.stats().triplets, triplets);
+  EXPECT_EQ(total(this->devices(), &DS18x20::Stats::eeprom_writes), writes);
+}
+
+TEST_F(HubTest, HubsAtOneAddressOnTwoBusesPersistApart) {
+  DS2482 second;
+  DS18x20 *a = this->add(0, DS18x20::DS18B20, 1, 5.0f);
+  this->devices_.push_back(std::make_unique<DS18x20>(DS18x20::DS18B20, 2, 6.0f));
+  DS18x20 *b = this->devices_.back().get();
+  second.channel(2).attach(b);
+
+  // Both at 0x18, told apart by their ids
+  auto boot = [&](LoopRunner &runner, DallasTemperatureSensor **sa, DallasTemperatureSensor **sb) {
+    auto *hub_a = new_hub(new_bus(), &this->chip_);
+    hub_a->set_persist_devices(true);
+    hub_a->set_persist_key("hub_a");
+    *sa = new_index_sensor(hub_a, 0);
+    auto *hub_b = new_hub(new_bus(), &second);
+    hub_b->set_persist_devices(true);
+    hub_b->set_persist_key("hub_b");
+    *sb = new_index_sensor(hub_b, 0);
+    runner.add(hub_a);
+    runner.add(hub_b);
+    runner.setup();
+  };
+  DallasTemperatureSensor *sa, *sb;
+  boot(this->runner_, &sa, &sb);
+  EXPECT_EQ(host::preferences().saves(), 2u);
+
+  uint32_t triplets = this->chip_.stats().triplets + second.stats().triplets;
+  LoopRunner runner;
+  boot(runner, &sa, &sb);
+  EXPECT_EQ(this->chip_.stats().triplets + second.stats().triplets, triplets);
+  ASSERT_TRUE(runner.run_until([&]() { return sa->get_publishes() >= 1 && sb->get_publishes() >= 1; }, 30000));
+  EXPECT_FLOAT_EQ(sa->get_state(), 5.0f);
+  EXPECT_FLOAT_EQ(sb->get_state(), 6.0f);
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 0u);
+}
+
+TEST_F(HubTest, PersistedDevicesFitTheFlashOfAnEsp8266) {
+  // All flash preferences of an ESP8266, other components take some as well
+  host::preferences().set_flash_budget(512);
+  for (uint8_t i = 0; i < 12; i++)
+    this->add(i % 4, DS18x20::DS18B20, i + 1, i);
+  auto *hub = this->hub();
+  hub->set_persist_devices(true);
+  auto *last = new_index_sensor(hub, 11);
+  this->runner_.setup();
+  EXPECT_EQ(host::preferences().saves(), 2u);
+  EXPECT_LE(host::preferences().flash_used(), 256u);
+
+  uint32_t triplets = this->chip_.stats().triplets;
+  hub = this->reboot();
+  hub->set_persist_devices(true);
+  last = new_index_sensor(hub, 11);
+  this->runner_.setup();
+  ASSERT_TRUE(this->run_publishes({last}, 1));
+  EXPECT_EQ(this->chip_.stats().triplets, triplets);
+  EXPECT_FLOAT_EQ(last->get_state(), 11.0f);
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 0u);
+}
+
+TEST_F(HubTest, CachedDeviceMovedToAnEmptyChannelIsFoundAgain) {
+  DS18x20 *a = this->add(0, DS18x20::DS18B20, 1, 5.0f);
+  auto *hub = this->hub();
+  hub->set_persist_devices(true);
+  new_index_sensor(hub, 0);
+  this->runner_.setup();
+
+  // Moved while powered off, nothing answers on its cached channel
+  this->chip_.channel(0).detach(a);
+  this->chip_.channel(4).attach(a);
+  uint32_t triplets = this->chip_.stats().triplets;
+  hub = this->reboot();
+  hub->set_persist_devices(true);
+  auto *sa = new_index_sensor(hub, 0);
+  this->runner_.setup();
+  EXPECT_EQ(this->chip_.stats().triplets, triplets);
+
+  ASSERT_TRUE(this->run_publishes({sa}, 1));
+  EXPECT_TRUE(std::isnan(sa->get_state()));
+  ASSERT_TRUE(this->run_publishes({sa}, 2));
+  EXPECT_FLOAT_EQ(sa->get_state(), 5.0f);
+  EXPECT_EQ(sa->get_channel(), 4);
+  EXPECT_GT(this->chip_.stats().triplets, triplets);
+  // The scans ran a transfer per loop like the rest of the sweep
+  EXPECT_LT(this->runner_.call_percentile(99), 2000u);
+}
+
+TEST_F(HubTest, CachedDeviceMovedOffAPopulatedChannelIsFoundAgain) {
+  DS18x20 *a = this->add(0, DS18x20::DS18B20, 1, 5.0f);
+  this->add(0, DS18x20::DS18B20, 2, 6.0f);
+  auto *hub = this->hub();
+  hub->set_persist_devices(true);
+  new_index_sensor(hub, 0);
+  new_index_sensor(hub, 1);
+  this->runner_.setup();
+
+  // The device left behind answers the reset, the moved one's scratch pad is garbage
+  this->chip_.channel(0).detach(a);
+  this->chip_.channel(4).attach(a);
+  hub = this->reboot();
+  hub->set_persist_devices(true);
+  auto *s0 = new_index_sensor(hub, 0);
+  auto *s1 = new_index_sensor(hub, 1);
+  this->runner_.setup();
+
+  ASSERT_TRUE(this->run_publishes({s0, s1}, 1));
+  EXPECT_FLOAT_EQ(s0->get_state(), 6.0f);
+  EXPECT_TRUE(std::isnan(s1->get_state()));
+  // Still second in search order, now on channel 4
+  ASSERT_TRUE(this->run_publishes({s0, s1}, 2));
+  EXPECT_FLOAT_EQ(s0->get_state(), 6.0f);
+  EXPECT_FLOAT_EQ(s1->get_state(), 5.0f);
+  EXPECT_EQ(s1->get_channel(), 4);
+  // Gone only for the scans in between, never unbound
+  EXPECT_EQ(host::log_count(ESPHOME_LOG_LEVEL_WARN), 2u);
+}
+
+TEST_F(HubTest, SweepConfiguresSensorsWithoutBlocking) {
+  std::vector<DS18x20 *> moved;
+  for (uint8_t i = 0; i < 3; i++)
+    moved.push_back(this->add(0, DS18x20::DS18B20, i + 1, 7.0f));
+  DS18x20 *p = this->add(2, DS18x20::DS18B20, 9, 8.0f);
+  p->parasite = true;
+  auto *hub = this->hub();
+  hub->set_persist_devices(true);
+  for (uint8_t i = 0; i < 4; i++)
+    new_index_sensor(hub, i);
+  this->runner_.setup();
+
+  // Moved to channel 4 and set to 9 bit: boot can't configure them, the sweep
+  // that finds them again does
+  for (auto *device : moved) {
+    this->chip_.channel(0).detach(device);
+    this->chip_.channel(4).attach(device);
+  }
+  hub = this->reboot();
+  hub->set_persist_devices(true);
+  std::vector<DallasTemperatureSensor *> sensors;
+  for (uint8_t i = 0; i < 4; i++)
+    sensors.push_back(new_index_sensor(hub, i, 9));
+  this->runner_.setup();
+  uint32_t writes = total(this->devices(), &DS18x20::Stats::eeprom_writes);
+  this->runner_.reset_stats();
+
+  ASSERT_TRUE(this->run_publishes(sensors, 2));
+  for (auto *device : this->devices())
+    EXPECT_EQ(device->resolution(), 9);
+  EXPECT_EQ(total(this->devices(), &DS18x20::Stats::eeprom_writes), writes + 3);
+  EXPECT_EQ(total(this->devices(), &DS18x20::Stats::interrupted_copies), 0u);
+  EXPECT_EQ(p->stats().brownouts, 0u);
+  EXPECT_FLOAT_EQ(sensors[0]->get_state(), 8.0f);
+  EXPECT_FLOAT_EQ(sensors[3]->get_state(), 7.0f);
+  EXPECT_LT(this->runner_.max_call_us(), 2000u);
+}
+
+}  // namespace sim
+}  // namespace esphome
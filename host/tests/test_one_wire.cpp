@@ -0,0 +1,346 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <regex>
+#include <set>
+#include <string>
+
+#include "esphome/core/hal.h"
+#include "esphome/host/log.h"
+#include "esphome/components/dallas_ds2482/esp_one_wire_800.h"
+#include "ds2482.h"
+#include "harness.h"
+
+namespace esphome {
+namespace sim {
+
+using dallas::ESPOneWire800;
+
+// The DS2482 driver against the simulated bridge, blocking and async API
+
+class OneWireTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    this->bus_->attach(0x18, &this->chip_);
+    this->wire_.set_i2c_bus(this->bus_);
+    this->wire_.set_i2c_address(0x18);
+    this->wire_.deviceReset();
+  }
+
+  DS18x20 *add(uint8_t channel, uint8_t family, uint64_t serial, float temperature = 21.5f) {
+    this->devices_.push_back(std::make_unique<DS18x20>(family, serial, temperature));
+    this->chip_.channel(channel).attach(this->devices_.back().get());
+    return this->devices_.back().get();
+  }
+
+  std::set<uint64_t> search(uint8_t channel, uint8_t family = 0) {
+    std::set<uint64_t> found;
+    EXPECT_TRUE(this->wire_.setChannel(channel));
+    if (family != 0)
+      this->wire_.wireTargetSearch(family);
+    else
+      this->wire_.wireResetSearch();
+    uint64_t rom;
+    while (!this->wire_.wireSearchDone() && this->wire_.wireSearch(&rom)) {
+      if (family != 0 && (rom & 0xFF) != family)
+        break;
+      found.insert(rom);
+    }
+    return found;
+  }
+
+  // Convert on the channel with SKIP ROM, parasite style if asked
+  void convert(uint8_t channel, bool power = false) {
+    ASSERT_TRUE(this->wire_.setChannel(channel));
+    ASSERT_TRUE(this->wire_.wireReset());
+    this->wire_.wireSkip();
+    this->wire_.wireWriteByte(0x44, power);
+    delay(800);
+  }
+
+  float temperature(const DS18x20 &device, bool *crc_ok = nullptr) {
+    uint8_t scratch_pad[9];
+    EXPECT_TRUE(this->wire_.wireSelectAndRead(device.rom(), 0xBE, scratch_pad, 9));
+    if (crc_ok != nullptr)
+      *crc_ok = ESPOneWire800::crc8(scratch_pad, 8) == scratch_pad[8];
+    return int16_t(scratch_pad[0] | scratch_pad[1] << 8) / 16.0f;
+  }
+
+  SimBus *bus_{new_bus()};
+  DS2482 chip_;
+  ESPOneWire800 wire_;
+  std::vector<std::unique_ptr<DS18x20>> devices_;
+};
+
+TEST_F(OneWireTest, SearchFindsEveryDeviceOnItsChannel) {
+  std::set<uint64_t> channel0, channel2;
+  for (uint64_t serial : {0x10, 0x2F, 0x31})
+    channel0.insert(this->add(0, DS18x20::DS18B20, serial)->rom());
+  channel2.insert(this->add(2, DS18x20::DS18S20, 0x77)->rom());
+  channel2.insert(this->add(2, DS18x20::DS1822, 0x78)->rom());
+  channel2.insert(this->add(2, DS18x20::DS28EA00, 0x79)->rom());
+
+  EXPECT_EQ(this->search(0), channel0);
+  EXPECT_EQ(this->search(2), channel2);
+  EXPECT_TRUE(this->search(5).empty());
+
+  // Target setup: the family code is fixed, the search stops past it
+  auto family = this->search(2, DS18x20::DS1822);
+  ASSERT_EQ(family.size(), 1u);
+  EXPECT_EQ(*family.begin() & 0xFF, DS18x20::DS1822);
+  EXPECT_EQ(this->chip_.stats().busy_violations, 0u);
+}
+
+TEST_F(OneWireTest, TargetSearchSkipsOtherFamilies) {
+  std::set<uint64_t> targets;
+  this->add(1, DS18x20::DS18S20, 0x01);
+  this->add(1, DS18x20::DS18S20, 0x02);
+  this->add(1, DS18x20::DS1822, 0x03);
+  targets.insert(this->add(1, DS18x20::DS18B20, 0x04)->rom());
+  targets.insert(this->add(1, DS18x20::DS18B20, 0x05)->rom());
+  this->add(1, DS18x20::DS28EA00, 0x06);
+
+  uint32_t triplets = this->chip_.stats().triplets;
+  EXPECT_EQ(this->search(1), this->search(1));
+  uint32_t full = this->chip_.stats().triplets - triplets;
+
+  // Starts on the family, the first ROM past it ends the search
+  ASSERT_TRUE(this->wire_.setChannel(1));
+  this->wire_.wireTargetSearch(DS18x20::DS18B20);
+  std::set<uint64_t> found;
+  uint64_t rom;
+  triplets = this->chip_.stats().triplets;
+  while (!this->wire_.wireSearchDone() && this->wire_.wireSearch(&rom) && (rom & 0xFF) == DS18x20::DS18B20)
+    found.insert(rom);
+  EXPECT_EQ(found, targets);
+  EXPECT_LT(this->chip_.stats().triplets - triplets, full / 2);
+}
+
+TEST_F(OneWireTest, ResetCountsMissingPresenceAndShorts) {
+  this->add(1, DS18x20::DS18B20, 1);
+  this->chip_.channel(3).shorted = true;
+
+  ASSERT_TRUE(this->wire_.setChannel(1));
+  EXPECT_TRUE(this->wire_.wireReset());
+  ASSERT_TRUE(this->wire_.setChannel(2));
+  EXPECT_FALSE(this->wire_.wireReset());
+  ASSERT_TRUE(this->wire_.setChannel(3));
+  EXPECT_FALSE(this->wire_.wireReset());
+
+  EXPECT_EQ(this->wire_.getChannelStats(1).noPresence, 0u);
+  EXPECT_EQ(this->wire_.getChannelStats(2).noPresence, 1u);
+  EXPECT_EQ(this->wire_.getChannelStats(3).shorts, 1u);
+
+  this->chip_.channel(1).presence_lost = true;
+  ASSERT_TRUE(this->wire_.setChannel(1));
+  EXPECT_FALSE(this->wire_.wireReset());
+  EXPECT_EQ(this->wire_.getChannelStats(1).noPresence, 1u);
+}
+
+#ifdef DALLAS_DS2482_TRACE
+TEST_F(OneWireTest, TraceKeepsTheLastEventsOldestFirst) {
+  this->add(2, DS18x20::DS18B20, 1);
+  ASSERT_TRUE(this->wire_.setChannel(2));
+  // Start from an empty ring
+  this->wire_.dumpTrace();
+
+  // 80 events for 64 places
+  for (uint8_t i = 0; i < 40; i++) {
+    ASSERT_TRUE(this->wire_.wireReset());
+    this->wire_.wireWriteByte(i);
+  }
+  std::vector<std::string> lines;
+  host::capture_log(&lines);
+  this->wire_.dumpTrace();
+  // Dumping empties the ring
+  this->wire_.dumpTrace();
+  host::capture_log(nullptr);
+
+  ASSERT_EQ(lines.size(), 1u + DALLAS_DS2482_TRACE + 1u);
+  EXPECT_EQ(lines.front(), "Trace, " + std::to_string(DALLAS_DS2482_TRACE) + " events:");
+  EXPECT_EQ(lines.back(), "Trace, 0 events:");
+  const std::regex entry(R"(  +(\d+) ch 2 (reset|write) +0x([0-9A-F]{2}))");
+  uint32_t last_time = 0;
+  for (uint8_t n = 0; n < DALLAS_DS2482_TRACE; n++) {
+    std::smatch match;
+    ASSERT_TRUE(std::regex_match(lines[1 + n], match, entry)) << lines[1 + n];
+    uint32_t time = std::stoul(match[1]);
+    EXPECT_GE(time, last_time);
+    last_time = time;
+    // The oldest 16 events were overwritten, the ring starts with the 9th reset
+    uint8_t data = std::stoul(match[3], nullptr, 16);
+    if (n % 2 == 0) {
+      EXPECT_EQ(match[2], "reset");
+      EXPECT_NE(data & DS2482_STATUS_PPD, 0);
+    } else {
+      EXPECT_EQ(match[2], "write");
+      EXPECT_EQ(data, 8 + n / 2);
+    }
+  }
+}
+#endif
+
+TEST_F(OneWireTest, ReadsTheScratchPadAndSeesCrcFaults) {
+  DS18x20 *device = this->add(4, DS18x20::DS18B20, 5, 23.75f);
+  this->convert(4);
+
+  bool crc_ok = false;
+  EXPECT_FLOAT_EQ(this->temperature(*device, &crc_ok), 23.75f);
+  EXPECT_TRUE(crc_ok);
+
+  device->crc_faults = 1;
+  this->temperature(*device, &crc_ok);
+  EXPECT_FALSE(crc_ok);
+  this->temperature(*device, &crc_ok);
+  EXPECT_TRUE(crc_ok);
+  EXPECT_EQ(device->stats().matches, 3u);
+}
+
+TEST_F(OneWireTest, TimedModeWaitsOutASlowBridge) {
+  // Oscillator at the slow end: the worst case durations must still cover it
+  this->chip_.set_timing_scale(1.1f);
+  for (uint64_t serial = 1; serial <= 4; serial++)
+    this->add(0, DS18x20::DS18B20, serial, 20.0f + serial);
+
+  this->wire_.setTimedMode(true);
+  EXPECT_EQ(this->search(0).size(), 4u);
+  this->convert(0);
+  for (auto &device : this->devices_)
+    EXPECT_FLOAT_EQ(this->temperature(*device), device->temperature);
+
+  EXPECT_EQ(this->chip_.stats().busy_violations, 0u);
+  EXPECT_EQ(this->wire_.getBusStats().timeouts, 0u);
+}
+
+TEST_F(OneWireTest, ParasiteConversionNeedsTheStrongPullup) {
+  DS18x20 *device = this->add(6, DS18x20::DS18B20, 9, 30.5f);
+  device->parasite = true;
+
+  this->convert(6, true);
+  EXPECT_FLOAT_EQ(this->temperature(*device), 30.5f);
+  EXPECT_EQ(device->stats().brownouts, 0u);
+
+  device->temperature = 31.0f;
+  this->convert(6, false);
+  EXPECT_EQ(device->stats().brownouts, 1u);
+  EXPECT_FLOAT_EQ(this->temperature(*device), 85.0f);
+}
+
+TEST_F(OneWireTest, ResumeReselectsTheLastDevice) {
+  DS18x20 *resumable = this->add(0, DS18x20::DS28EA00, 1, 19.0f);
+  DS18x20 *other = this->add(0, DS18x20::DS18B20, 2, 20.0f);
+  this->convert(0);
+
+  bool crc_ok = false;
+  EXPECT_FLOAT_EQ(this->temperature(*resumable), 19.0f);
+  EXPECT_FLOAT_EQ(this->temperature(*resumable, &crc_ok), 19.0f);
+  EXPECT_TRUE(crc_ok);
+  EXPECT_EQ(resumable->stats().resumes, 1u);
+  EXPECT_EQ(this->wire_.getResumesUsed(), 1u);
+
+  // Another device in between deselects it
+  EXPECT_FLOAT_EQ(this->temperature(*other), 20.0f);
+  EXPECT_FLOAT_EQ(this->temperature(*resumable), 19.0f);
+  EXPECT_EQ(resumable->stats().resumes, 1u);
+  EXPECT_EQ(resumable->stats().matches, 2u);
+  EXPECT_EQ(this->wire_.getResumesUsed(), 1u);
+}
+
+TEST_F(OneWireTest, ReselectingTheChannelIsFree) {
+  this->add(3, DS18x20::DS18B20, 1);
+  ASSERT_TRUE(this->wire_.setChannel(3));
+  uint32_t transfers = this->bus_->transfers();
+  ASSERT_TRUE(this->wire_.setChannel(3));
+  EXPECT_EQ(this->bus_->transfers(), transfers);
+  EXPECT_EQ(this->wire_.getChannelSelectsSaved(), 1u);
+  EXPECT_EQ(this->chip_.selected_channel(), 3);
+}
+
+TEST_F(OneWireTest, AsyncPollIsOneTransferAtATime) {
+  DS18x20 *device = this->add(5, DS18x20::DS18B20, 3, -5.5f);
+  device->parasite = true;
+  uint64_t rom = device->rom();
+  uint8_t scratch_pad[9];
+
+  auto run = [this]() {
+    uint8_t result;
+    uint32_t polls = 0;
+    do {
+      uint32_t before = this->bus_->transfers();
+      result = this->wire_.asyncPoll();
+      EXPECT_LE(this->bus_->transfers() - before, 1u);
+      delayMicroseconds(50);
+      polls++;
+    } while (result == DS2482_ASYNC_PENDING && polls < 10000);
+    return result;
+  };
+
+  // Conversion on the strong pullup
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_CHANNEL, 5));
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_RESET));
+  ASSERT_TRUE(this->wire_.asyncQueueSelect(&rom));
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_PULLUP, 1));
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_WRITE, 0x44));
+  EXPECT_EQ(run(), DS2482_ASYNC_DONE);
+  EXPECT_TRUE(this->chip_.pullup_active());
+  delay(800);
+
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_PULLUP, 0));
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_RESET));
+  ASSERT_TRUE(this->wire_.asyncQueueSelect(&rom));
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_WRITE, 0xBE));
+  for (uint8_t i = 0; i < 9; i++)
+    ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_READ, 1, scratch_pad + i));
+  EXPECT_EQ(run(), DS2482_ASYNC_DONE);
+
+  EXPECT_EQ(ESPOneWire800::crc8(scratch_pad, 8), scratch_pad[8]);
+  EXPECT_FLOAT_EQ(int16_t(scratch_pad[0] | scratch_pad[1] << 8) / 16.0f, -5.5f);
+  EXPECT_EQ(device->stats().brownouts, 0u);
+  EXPECT_EQ(this->chip_.stats().busy_violations, 0u);
+  EXPECT_EQ(this->chip_.stats().bad_transfers, 0u);
+}
+
+TEST_F(OneWireTest, AsyncPullupRereadsAnUnknownConfig) {
+  auto run = [this]() {
+    uint8_t result;
+    do {
+      result = this->wire_.asyncPoll();
+      delayMicroseconds(50);
+    } while (result == DS2482_ASYNC_PENDING);
+    return result;
+  };
+
+  // The device reset clears the config register, the shadow still says APU but is invalid
+  this->wire_.writeConfig(DS2482_CONFIG_APU);
+  ASSERT_EQ(this->chip_.config(), DS2482_CONFIG_APU);
+  this->wire_.deviceReset();
+  ASSERT_EQ(this->chip_.config(), 0);
+
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_PULLUP, 1));
+  EXPECT_EQ(run(), DS2482_ASYNC_DONE);
+  EXPECT_EQ(this->chip_.config(), DS2482_CONFIG_SPU);
+  EXPECT_EQ(this->wire_.readConfig(), DS2482_CONFIG_SPU);
+
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_PULLUP, 0));
+  EXPECT_EQ(run(), DS2482_ASYNC_DONE);
+  EXPECT_EQ(this->chip_.config(), 0);
+  EXPECT_EQ(this->chip_.stats().bad_transfers, 0u);
+}
+
+TEST_F(OneWireTest, AsyncResetFailsOnAnEmptyChannel) {
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_CHANNEL, 7));
+  ASSERT_TRUE(this->wire_.asyncQueue(dallas::ASYNC_OP_RESET));
+  uint8_t result;
+  do {
+    result = this->wire_.asyncPoll();
+    delayMicroseconds(100);
+  } while (result == DS2482_ASYNC_PENDING);
+  EXPECT_EQ(result, DS2482_ASYNC_FAILED);
+  EXPECT_FALSE(this->wire_.asyncActive());
+  EXPECT_EQ(this->wire_.getChannelStats(7).noPresence, 1u);
+}
+
+}  // namespace sim
+}  // namespace esphome
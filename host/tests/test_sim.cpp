@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/host/clock.h"
+#include "ds2482.h"
+#include "harness.h"
+
+namespace esphome {
+namespace sim {
+
+// The models on their own, driven with raw DS2482 commands
+
+static bool write2(SimBus *bus, uint8_t a, uint8_t b) {
+  uint8_t data[2] = {a, b};
+  return bus->write(0x18, data, 2) == i2c::ERROR_OK;
+}
+
+static uint8_t read1(SimBus *bus) {
+  uint8_t data = 0;
+  bus->read(0x18, &data, 1);
+  return data;
+}
+
+TEST(Sim, RomCarriesFamilyAndCrc) {
+  DS18x20 device(DS18x20::DS18B20, 0x123456789ABCULL);
+  uint8_t rom[8];
+  for (uint8_t i = 0; i < 8; i++)
+    rom[i] = device.rom() >> (8 * i);
+  EXPECT_EQ(rom[0], 0x28);
+  EXPECT_EQ(rom[1], 0xBC);
+  EXPECT_EQ(crc8(rom, 7), rom[7]);
+}
+
+TEST(Sim, ChannelSelectAndConfigCheck) {
+  SimBus *bus = new_bus();
+  DS2482 chip;
+  bus->attach(0x18, &chip);
+
+  EXPECT_TRUE(write2(bus, 0xC3, 0xD2));
+  EXPECT_EQ(read1(bus), 0xAA);
+  EXPECT_EQ(chip.selected_channel(), 2);
+  // Unknown channel code
+  EXPECT_FALSE(write2(bus, 0xC3, 0x12));
+
+  // APU with its complement in the upper nibble, then without
+  EXPECT_TRUE(write2(bus, 0xD2, 0xE1));
+  EXPECT_EQ(read1(bus), 0x01);
+  EXPECT_FALSE(write2(bus, 0xD2, 0x01));
+  EXPECT_EQ(chip.stats().bad_transfers, 2u);
+
+  // The DS2482-100 has no channels to select
+  DS2482 single(1);
+  bus->attach(0x19, &single);
+  uint8_t select[2] = {0xC3, 0xF0};
+  EXPECT_NE(bus->write(0x19, select, 2), i2c::ERROR_OK);
+}
+
+TEST(Sim, CommandsWhileBusyAreRefused) {
+  SimBus *bus = new_bus();
+  DS2482 chip;
+  bus->attach(0x18, &chip);
+  DS18x20 device(DS18x20::DS18B20, 1);
+  chip.channel(0).attach(&device);
+
+  uint8_t reset = 0xB4;
+  ASSERT_EQ(bus->write(0x18, &reset, 1), i2c::ERROR_OK);
+  EXPECT_TRUE(read1(bus) & 0x01);
+  EXPECT_FALSE(write2(bus, 0xA5, 0xCC));
+  EXPECT_EQ(chip.stats().busy_violations, 1u);
+
+  delayMicroseconds(1200);
+  uint8_t status = read1(bus);
+  EXPECT_FALSE(status & 0x01);
+  EXPECT_TRUE(status & 0x02);  // presence
+  EXPECT_TRUE(write2(bus, 0xA5, 0xCC));
+}
+
+TEST(Sim, ConversionTakesItsTimeAndEncodesTheTemperature) {
+  SimBus *bus = new_bus();
+  DS2482 chip;
+  bus->attach(0x18, &chip);
+  DS18x20 device(DS18x20::DS18B20, 1, -10.0625f);
+  device.conversion_speed = 1.0f;
+  chip.channel(0).attach(&device);
+  auto &line = chip.channel(0);
+
+  ASSERT_TRUE(line.reset(host::now_us()));
+  line.write_byte(0xCC, host::now_us());
+  line.write_byte(0x44, host::now_us());
+  EXPECT_FALSE(line.slot(true, host::now_us()));
+  delay(749);
+  EXPECT_FALSE(line.slot(true, host::now_us()));
+  delay(2);
+  EXPECT_TRUE(line.slot(true, host::now_us()));
+
+  line.reset(host::now_us());
+  line.write_byte(0xCC, host::now_us());
+  line.write_byte(0xBE, host::now_us());
+  uint8_t scratch_pad[9];
+  for (auto &byte : scratch_pad)
+    byte = line.read_byte(host::now_us());
+  EXPECT_EQ(crc8(scratch_pad, 8), scratch_pad[8]);
+  EXPECT_EQ(int16_t(scratch_pad[0] | scratch_pad[1] << 8), -161);
+  EXPECT_EQ(scratch_pad[4], 0x7F);
+  EXPECT_EQ(device.stats().conversions, 1u);
+}
+
+}  // namespace sim
+}  // namespace esphome
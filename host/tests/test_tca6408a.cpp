@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include "esphome/core/hal.h"
+#include "esphome/components/tca6408a/tca6408a.h"
+#include "ds2482.h"
+#include "harness.h"
+#include "tca6408a.h"
+
+namespace esphome {
+namespace sim {
+
+using tca6408a::TCA6408AComponent;
+
+// The expander and the DS2482 hub sharing one bus through the arbiter
+
+class SharedBusTest : public ::testing::Test {
+ protected:
+  TCA6408AComponent *expander() {
+    this->bus_->attach(0x20, &this->tca_);
+    auto *expander = new TCA6408AComponent();  // NOLINT(cppcoreguidelines-owning-memory)
+    expander->set_i2c_bus(this->bus_);
+    expander->set_i2c_address(0x20);
+    expander->set_input_interval(10);
+    this->runner_.add(expander);
+    return expander;
+  }
+
+  SimBus *bus_{new_bus()};
+  TCA6408A tca_;
+  DS2482 chip_;
+  LoopRunner runner_;
+};
+
+TEST_F(SharedBusTest, OutputsOnlyNeverPollTheInputs) {
+  auto *expander = this->expander();
+  this->runner_.setup();
+  expander->pin_mode(0, gpio::FLAG_OUTPUT);
+  expander->digital_write(0, true);
+  EXPECT_EQ(this->tca_.output() & 0x01, 0x01);
+
+  uint32_t reads = this->tca_.input_reads();
+  this->runner_.run_for(1000);
+  EXPECT_EQ(this->tca_.input_reads(), reads);
+}
+
+TEST_F(SharedBusTest, InputPinStartsThePolling) {
+  auto *expander = this->expander();
+  this->runner_.setup();
+  expander->pin_mode(3, gpio::Flags(gpio::FLAG_INPUT | gpio::FLAG_PULLUP));
+  EXPECT_EQ(this->tca_.config() & 0x08, 0x08);
+
+  this->tca_.inputs = 0x08;
+  uint32_t reads = this->tca_.input_reads();
+  this->runner_.run_for(1000);
+  // Once per main loop iteration at most, the loop runs every 16 ms
+  EXPECT_GE(this->tca_.input_reads() - reads, 50u);
+  EXPECT_TRUE(expander->digital_read(3));
+  this->tca_.inputs = 0;
+  this->runner_.run_for(20);
+  EXPECT_FALSE(expander->digital_read(3));
+}
+
+TEST_F(SharedBusTest, HubAccountsEveryTransfer) {
+  DS18x20 device(DS18x20::DS18B20, 1, 24.0f);
+  this->chip_.channel(0).attach(&device);
+  auto *hub = new_hub(this->bus_, &this->chip_);
+  auto *sensor = new_sensor(hub, device, 0);
+  this->runner_.add(hub);
+  this->runner_.setup();
+  ASSERT_TRUE(this->runner_.run_until([&]() { return sensor->has_state(); }, 10000));
+  EXPECT_FLOAT_EQ(sensor->get_state(), 24.0f);
+
+  // The hub is the only client: its bus time is all of the bus time
+  EXPECT_EQ(hub->getArbiter()->get_bus_time(0), this->bus_->busy_us());
+}
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "esphome/core/hal.h"
+#include "esphome/components/tca6408a/tca6408a.h"
+#include "esphome/host/clock.h"
+#include "ds2482.h"
+#include "harness.h"
+#include "tca6408a.h"
+
+namespace esphome {
+namespace sim {
+
+using dallas::DallasTemperatureSensor;
+using tca6408a::TCA6408AComponent;
+
+// The DS2482 worker task next to the main loop, on one bus and the real clock.
+// Nothing here is freed: the worker runs until the process ends, as on a device.
+
+TEST(WorkerTest, SharesTheBusWithTheMainLoop) {
+  host::use_real_clock(true);
+  SimBus *bus = new_bus();
+  auto *chip = new DS2482();  // NOLINT(cppcoreguidelines-owning-memory)
+  auto *tca = new TCA6408A();  // NOLINT(cppcoreguidelines-owning-memory)
+  bus->attach(0x20, tca);
+
+  auto *expander = new TCA6408AComponent();  // NOLINT(cppcoreguidelines-owning-memory)
+  expander->set_i2c_bus(bus);
+  expander->set_i2c_address(0x20);
+  expander->set_input_interval(5);
+  auto *hub = new_hub(bus, chip);
+  hub->set_update_interval(250);
+  std::vector<DallasTemperatureSensor *> sensors;
+  for (uint8_t i = 0; i < 6; i++) {
+    auto *device = new DS18x20(DS18x20::DS18B20, i + 1, 20.0f + i);  // NOLINT(cppcoreguidelines-owning-memory)
+    chip->channel(i % 3).attach(device);
+    sensors.push_back(new_sensor(hub, *device, i % 3, 9));
+  }
+  LoopRunner runner;
+  runner.add(expander);
+  runner.add(hub);
+  runner.setup();
+  expander->pin_mode(0, gpio::FLAG_INPUT);
+  runner.reset_stats();
+
+  // Clients in setup order: the expander, then the hub. The worker starts with
+  // the hub's first loop(), after this.
+  auto *arbiter = hub->getArbiter();
+  uint32_t tca_accounted = arbiter->get_transfers(0);
+  uint32_t hub_accounted = arbiter->get_transfers(1);
+  uint32_t tca_transfers = bus->transfers(0x20);
+  uint32_t hub_transfers = bus->transfers(0x18);
+
+  // The expander inputs keep their cadence while the worker sweeps
+  uint64_t worst = 0;
+  for (uint8_t i = 0; i < 20; i++) {
+    bool level = i & 1;
+    tca->inputs = level;
+    uint64_t start = host::now_us();
+    ASSERT_TRUE(runner.run_until([&]() { return expander->digital_read(0) == level; }, 1000));
+    worst = std::max(worst, host::now_us() - start);
+    runner.run_for(37);
+  }
+  ASSERT_TRUE(runner.run_until(
+      [&]() {
+        return std::all_of(sensors.begin(), sensors.end(),
+                           [](DallasTemperatureSensor *sensor) { return sensor->get_publishes() >= 3; });
+      },
+      10000));
+
+  for (uint8_t i = 0; i < 6; i++)
+    EXPECT_FLOAT_EQ(sensors[i]->get_state(), 20.0f + i);
+  EXPECT_EQ(bus->overlaps(), 0u);
+  EXPECT_EQ(chip->stats().busy_violations, 0u);
+  EXPECT_EQ(chip->stats().bad_transfers, 0u);
+  // One input period and one main loop iteration, with some room for the scheduler
+  EXPECT_LT(worst, 50000u);
+  // Real time, so a loop() call also pays for the host scheduler and any wait on the bus lock
+  EXPECT_LT(runner.call_percentile(99), 5000u);
+
+  // Counted from both threads; consistent while nobody is on the bus. An input
+  // read is a register address write and a read.
+  arbiter->lock_bus();
+  EXPECT_EQ(2 * (arbiter->get_transfers(0) - tca_accounted), bus->transfers(0x20) - tca_transfers);
+  EXPECT_EQ(arbiter->get_transfers(1) - hub_accounted, bus->transfers(0x18) - hub_transfers);
+  arbiter->unlock_bus();
+}
+
+}  // namespace sim
+}  // namespace esphome
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  int result = RUN_ALL_TESTS();
+  // The worker is still running, leave without destroying what it uses
+  std::_Exit(result);
+}
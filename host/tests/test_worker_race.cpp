@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "esphome/core/hal.h"
+#include "esphome/host/clock.h"
+#include "ds2482.h"
+#include "harness.h"
+
+namespace esphome {
+namespace sim {
+
+using dallas::DallasTemperatureSensor;
+
+// What the main loop does with a hub while its worker task sweeps, built with
+// ThreadSanitizer: dump_config(), the sensor accessors, trace dumps, publishing
+// and rescans that change the device table. Any data race ends the process.
+// Nothing here is freed: the worker runs until the process ends, as on a device.
+
+TEST(WorkerRaceTest, MainLoopReadsWhileTheWorkerSweeps) {
+  host::use_real_clock(true);
+  SimBus *bus = new_bus();
+  auto *chip = new DS2482();  // NOLINT(cppcoreguidelines-owning-memory)
+  auto *hub = new_hub(bus, chip);
+  hub->set_update_interval(100);
+  hub->set_rescan(true);
+  hub->set_alarm_search(true);
+
+  std::vector<DS18x20 *> devices;
+  std::vector<DallasTemperatureSensor *> sensors;
+  for (uint8_t i = 0; i < 4; i++) {
+    auto *device = new DS18x20(DS18x20::DS18B20, i + 1, 20.0f + i);  // NOLINT(cppcoreguidelines-owning-memory)
+    chip->channel(i % 2).attach(device);
+    devices.push_back(device);
+    sensors.push_back(new_sensor(hub, *device, i % 2, 9));
+  }
+  sensors[0]->set_alarm_high(10);
+  // Bound to a device the rescans add and remove
+  auto *late = new DS18x20(DS18x20::DS18B20, 0x40, 30.0f);  // NOLINT(cppcoreguidelines-owning-memory)
+  late->connected = false;
+  chip->channel(2).attach(late);
+  auto *index_sensor = new_index_sensor(hub, 4, 9);
+  sensors.push_back(index_sensor);
+
+  LoopRunner runner;
+  runner.add(hub);
+  runner.setup();
+
+  auto *arbiter = hub->getArbiter();
+  for (uint8_t round = 0; round < 20; round++) {
+    // The simulated devices are only touched under the bus lock, like the worker does
+    arbiter->lock_bus();
+    late->connected = round % 4 < 2;
+    arbiter->unlock_bus();
+
+    runner.run_for(50);
+    hub->dump_config();
+    // Logged by the worker, which writes the trace
+    if (round % 8 == 0)
+      hub->dump_trace();
+    for (auto *sensor : sensors) {
+      EXPECT_FALSE(sensor->get_address_name().empty());
+      EXPECT_FALSE(sensor->unique_id().empty());
+      if (sensor->has_latest())
+        EXPECT_FALSE(std::isinf(sensor->get_latest()));
+      sensor->is_alarm_tripped();
+    }
+  }
+
+  ASSERT_TRUE(runner.run_until(
+      [&]() {
+        return std::all_of(sensors.begin(), sensors.end() - 1,
+                           [](DallasTemperatureSensor *sensor) { return sensor->get_publishes() >= 3; });
+      },
+      10000));
+  for (uint8_t i = 1; i < 4; i++)
+    EXPECT_FLOAT_EQ(sensors[i]->get_state(), 20.0f + i);
+  EXPECT_EQ(bus->overlaps(), 0u);
+  EXPECT_EQ(chip->stats().busy_violations, 0u);
+}
+
+}  // namespace sim
+}  // namespace esphome
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  int result = RUN_ALL_TESTS();
+  // The worker is still running, leave without destroying what it uses
+  std::_Exit(result);
+}
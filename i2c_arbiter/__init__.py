@@ -0,0 +1,9 @@
+import esphome.config_validation as cv
+import esphome.codegen as cg
+
+# Loaded by the components sharing an I2C bus, nothing to configure
+DEPENDENCIES = ["i2c"]
+
+i2c_arbiter_ns = cg.esphome_ns.namespace("i2c_arbiter")
+
+CONFIG_SCHEMA = cv.Schema({})
@@ -0,0 +1,67 @@
+#include "i2c_arbiter.h"
+#include "esphome/core/log.h"
+
+#include <cinttypes>
+
+namespace esphome {
+namespace i2c_arbiter {
+
+static const char *const TAG = "i2c_arbiter";
+
+static std::vector<I2CBusArbiter *> arbiters;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+I2CBusArbiter *I2CBusArbiter::get(i2c::I2CBus *bus) {
+  for (auto *arbiter : arbiters) {
+    if (arbiter->bus_ == bus)
+      return arbiter;
+  }
+  auto *arbiter = new I2CBusArbiter();  // NOLINT(cppcoreguidelines-owning-memory)
+  arbiter->bus_ = bus;
+  arbiter->logged_at_ = millis();
+  arbiters.push_back(arbiter);
+  return arbiter;
+}
+
+uint8_t I2CBusArbiter::add_client(const char *name, uint8_t address) {
+  this->clients_.push_back({name, address, 0, 0, 0, 0});
+  return this->clients_.size() - 1;
+}
+
+void I2CBusArbiter::add_job(uint8_t client, Priority priority, uint32_t interval_us, std::function<void()> &&job) {
+  this->jobs_.push_back({client, priority, interval_us, micros(), std::move(job)});
+}
+
+void I2CBusArbiter::service(Priority min_priority) {
+  if (this->servicing_)
+    return;
+  this->servicing_ = true;
+  uint32_t now = micros();
+  for (auto &job : this->jobs_) {
+    if (job.priority < min_priority || int32_t(now - job.next) < 0)
+      continue;
+    job.callback();
+    // Keep the cadence, unless the job fell more than a whole interval behind
+    job.next += job.interval_us;
+    if (int32_t(now - job.next) >= 0)
+      job.next = now + job.interval_us;
+  }
+  this->servicing_ = false;
+}
+
+void I2CBusArbiter::log_stats() {
+  LockGuard guard(this->stats_lock_);
+  uint32_t elapsed = std::max<uint32_t>(millis() - this->logged_at_, 1);
+  this->logged_at_ += elapsed;
+  for (auto &client : this->clients_) {
+    uint32_t us = client.bus_us - client.logged_us;
+    // µs per ms is per mille, shown as a percentage with one decimal
+    uint32_t share = us / elapsed;
+    ESP_LOGD(TAG, "Bus time %s@0x%02X: %" PRIu32 " transfers, %" PRIu32 " ms, %" PRIu32 ".%" PRIu32 "%%", client.name,
+             client.address, client.transfers - client.logged_transfers, us / 1000, share / 10, share % 10);
+    client.logged_us = client.bus_us;
+    client.logged_transfers = client.transfers;
+  }
+}
+
+}  // namespace i2c_arbiter
+}  // namespace esphome
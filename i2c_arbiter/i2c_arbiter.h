@@ -0,0 +1,110 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/i2c/i2c.h"
+
+namespace esphome {
+namespace i2c_arbiter {
+
+enum Priority : uint8_t {
+  /// Runs from the owner's own loop().
+  PRIORITY_NORMAL,
+  /// Also runs between the transfers of other devices on the bus, e.g. while a
+  /// DS2482 busy waits on a 1-Wire reset.
+  PRIORITY_URGENT,
+};
+
+/// Shares one I2C bus between the devices on it.
+///
+/// Devices register as clients and account the time their transfers take, so the
+/// bus time of each can be compared. Latency sensitive work is registered as a
+/// recurring job, which devices holding the bus for long run between their
+/// transfers with service(). Jobs run on the thread calling service(); a client
+/// stepped from another thread must not call it. Clients hold the bus lock for
+/// every transfer, so a DS2482 worker task and the main loop take turns on it.
+class I2CBusArbiter {
+ public:
+  /// The arbiter of a bus, created on first use.
+  static I2CBusArbiter *get(i2c::I2CBus *bus);
+
+  /// Register a device on the bus, returns its client id for account() and add_job().
+  uint8_t add_client(const char *name, uint8_t address);
+  /// Run `job` every `interval_us` µs from service() calls at `priority` or below.
+  void add_job(uint8_t client, Priority priority, uint32_t interval_us, std::function<void()> &&job);
+  /// Run the jobs that are due and at least `min_priority`.
+  void service(Priority min_priority);
+
+  /// Take the bus for one transfer (or a write and read with repeated start).
+  void lock_bus() { this->bus_lock_.lock(); }
+  void unlock_bus() { this->bus_lock_.unlock(); }
+
+  /// Credit a transfer of `us` µs to a client.
+  void account(uint8_t client, uint32_t us) {
+    LockGuard guard(this->stats_lock_);
+    this->clients_[client].bus_us += us;
+    this->clients_[client].transfers++;
+  }
+  uint32_t get_bus_time(uint8_t client) {
+    LockGuard guard(this->stats_lock_);
+    return this->clients_[client].bus_us;
+  }
+  uint32_t get_transfers(uint8_t client) {
+    LockGuard guard(this->stats_lock_);
+    return this->clients_[client].transfers;
+  }
+  /// Log the bus time of every client since the last call.
+  void log_stats();
+
+ protected:
+  struct Client {
+    const char *name;
+    uint8_t address;
+    uint32_t bus_us;
+    uint32_t transfers;
+    /// bus_us and transfers at the last log_stats().
+    uint32_t logged_us;
+    uint32_t logged_transfers;
+  };
+  struct Job {
+    uint8_t client;
+    Priority priority;
+    uint32_t interval_us;
+    /// micros() at which the job is due next.
+    uint32_t next;
+    std::function<void()> callback;
+  };
+
+  i2c::I2CBus *bus_;
+  std::vector<Client> clients_;
+  std::vector<Job> jobs_;
+  /// A job is running, its own transfers must not run jobs again.
+  bool servicing_{false};
+  Mutex bus_lock_;
+  /// The counters of clients are written from the thread of each client.
+  Mutex stats_lock_;
+  uint32_t logged_at_{0};
+};
+
+/// Holds the bus of an arbiter while in scope, nothing without an arbiter.
+class BusGuard {
+ public:
+  explicit BusGuard(I2CBusArbiter *arbiter) : arbiter_(arbiter) {
+    if (this->arbiter_ != nullptr)
+      this->arbiter_->lock_bus();
+  }
+  ~BusGuard() {
+    if (this->arbiter_ != nullptr)
+      this->arbiter_->unlock_bus();
+  }
+  BusGuard(const BusGuard &) = delete;
+  BusGuard &operator=(const BusGuard &) = delete;
+
+ protected:
+  I2CBusArbiter *arbiter_;
+};
+
+}  // namespace i2c_arbiter
+}  // namespace esphome
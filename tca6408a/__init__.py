@@ -12,6 +12,7 @@ from esphome.const import (
 )
 
 DEPENDENCIES = ["i2c"]
+AUTO_LOAD = ["i2c_arbiter"]
 MULTI_CONF = True
 
 tca6408a_ns = cg.esphome_ns.namespace("tca6408a")
@@ -21,6 +22,7 @@ TCA6408AGPIOPin = tca6408a_ns.class_("TCA6408AGPIOPin", cg.GPIOPin)
 
 CONF_TCA6408A = "tca6408a"
 CONF_DEFAULT_ON = "default_on"
+CONF_INPUT_INTERVAL = "input_interval"
 
 CONFIG_SCHEMA = (
     cv.Schema(
@@ -28,6 +30,10 @@ CONFIG_SCHEMA = (
             cv.Required(CONF_ID): cv.declare_id(TCA6408AComponent),
             cv.Optional(CONF_TCA6408A, default=False): cv.boolean,
             cv.Optional(CONF_DEFAULT_ON, default=False): cv.boolean,
+            # Also read while other devices hold the bus, e.g. a DS2482 search
+            cv.Optional(
+                CONF_INPUT_INTERVAL, default="10ms"
+            ): cv.positive_time_period_milliseconds,
         }
     )
     .extend(cv.COMPONENT_SCHEMA)
@@ -41,6 +47,7 @@ async def to_code(config):
     await cg.register_component(var, config)
     await i2c.register_i2c_device(var, config)
     #cg.add(var.set_tca6408a(config[CONF_TCA6408A]))
+    cg.add(var.set_input_interval(config[CONF_INPUT_INTERVAL]))
 
 
 def validate_mode(value):
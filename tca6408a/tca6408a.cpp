@@ -1,6 +1,8 @@
 #include "tca6408a.h"
 #include "esphome/core/log.h"
 
+#include <cinttypes>
+
 namespace esphome {
 namespace tca6408a {
 
@@ -14,26 +16,42 @@ void TCA6408AComponent::setup() {
     return;
   }
 
-  this->ignore_ = 100;
-
   this->write_gpio_();
   this->read_gpio_();
+
+  this->arbiter_ = i2c_arbiter::I2CBusArbiter::get(this->bus_);
+  this->client_ = this->arbiter_->add_client("tca6408a", this->address_);
+  // Pins are usually set up after the expander, the first input starts the polling
+  if (this->mode_mask_ != 0)
+    this->start_polling_();
+}
+void TCA6408AComponent::start_polling_() {
+  if (this->polling_ || this->arbiter_ == nullptr)
+    return;
+  this->polling_ = true;
+  // Urgent, so a DS2482 busy waiting on the same bus doesn't hold the inputs back
+  this->arbiter_->add_job(this->client_, i2c_arbiter::PRIORITY_URGENT, this->input_interval_ * 1000,
+                          [this]() { this->read_gpio_(); });
+}
+void TCA6408AComponent::loop() {
+  if (this->arbiter_ != nullptr)
+    this->arbiter_->service(i2c_arbiter::PRIORITY_NORMAL);
 }
 void TCA6408AComponent::dump_config() {
   ESP_LOGCONFIG(TAG, "TCA6408A:");
   LOG_I2C_DEVICE(this)
+  if (this->polling_) {
+    ESP_LOGCONFIG(TAG, "  Input interval: %" PRIu32 " ms", this->input_interval_);
+  } else {
+    ESP_LOGCONFIG(TAG, "  No input pins, inputs not polled");
+  }
   //ESP_LOGCONFIG(TAG, "  Is PCF8575: %s", YESNO(this->pcf8575_));
   if (this->is_failed()) {
     ESP_LOGE(TAG, "Communication with TCA6408A failed!");
   }
 }
 bool TCA6408AComponent::digital_read(uint8_t pin) {
-  if(this->ignore_)
-    this->ignore_--;
-  else{
-    this->read_gpio_();
-    this->ignore_ = 100;
-  }
+  // Refreshed every input_interval_ by the arbiter job
   return this->input_mask_ & (1 << pin);
 }
 void TCA6408AComponent::digital_write(uint8_t pin, bool value) {
@@ -43,7 +61,12 @@ void TCA6408AComponent::digital_write(uint8_t pin, bool value) {
   }else{
 
     uint8_t data[2];
-    this->read_register(0x1, data, 1);
+    {
+      i2c_arbiter::BusGuard guard(this->arbiter_);
+      uint32_t start = micros();
+      this->read_register(0x1, data, 1);
+      this->account_(start);
+    }
 
     this->output_mask_ = data[0];
 
@@ -60,14 +83,20 @@ void TCA6408AComponent::pin_mode(uint8_t pin, gpio::Flags flags) {
 
   uint8_t data[2];
 
-  this->read_register(0x3, data, 1);
+  {
+    i2c_arbiter::BusGuard guard(this->arbiter_);
+    uint32_t start = micros();
+    this->read_register(0x3, data, 1);
+    this->account_(start);
+  }
   this->mode_mask_ = data[0];
 
-  if (flags == gpio::FLAG_INPUT) {
+  if (flags & gpio::FLAG_INPUT) {
     // Clear mode mask bit
     this->mode_mask_ |= (1 << pin);
     // Write GPIO to enable input mode
     this->write_gpio_();
+    this->start_polling_();
   } else if (flags == gpio::FLAG_OUTPUT) {
     // Set mode mask bit
     this->mode_mask_ &= ~(1 << pin);
@@ -77,10 +106,13 @@ void TCA6408AComponent::pin_mode(uint8_t pin, gpio::Flags flags) {
   data[0] = this->mode_mask_;
   data[1] = 0;//value >> 8;
 
+  i2c_arbiter::BusGuard guard(this->arbiter_);
+  uint32_t start = micros();
   if (this->write_register(0x03, data, 1) != i2c::ERROR_OK) {
     this->status_set_warning();
     //return false;
   }
+  this->account_(start);
 
   //ESP_LOGD(TAG, "Mode");
   //ESP_LOGD(TAG, "Input: %X", this->input_mask_);
@@ -96,7 +128,12 @@ bool TCA6408AComponent::read_gpio_() {
   //  success = this->read_bytes_raw(data, 2);
   //  this->input_mask_ = (uint16_t(data[1]) << 8) | (uint16_t(data[0]) << 0);
   //} else {
-    success = this->read_register(0x0, data, 1);
+    {
+      i2c_arbiter::BusGuard guard(this->arbiter_);
+      uint32_t start = micros();
+      success = this->read_register(0x0, data, 1);
+      this->account_(start);
+    }
     this->input_mask_ = data[0];
   //}
 
@@ -136,7 +173,14 @@ bool TCA6408AComponent::write_gpio_() {
   data[0] = this->output_mask_;
   //data[1] = value >> 8;
 
-  if (this->write_register(0x01, data, 1) != i2c::ERROR_OK) {
+  bool ok;
+  {
+    i2c_arbiter::BusGuard guard(this->arbiter_);
+    uint32_t start = micros();
+    ok = this->write_register(0x01, data, 1) == i2c::ERROR_OK;
+    this->account_(start);
+  }
+  if (!ok) {
     this->status_set_warning();
     return false;
   }
@@ -149,6 +193,11 @@ bool TCA6408AComponent::write_gpio_() {
   //ESP_LOGD(TAG, "Mode: %X", this->mode_mask_);
   return true;
 }
+void TCA6408AComponent::account_(uint32_t start) {
+  // Not registered yet during setup()
+  if (this->arbiter_ != nullptr)
+    this->arbiter_->account(this->client_, micros() - start);
+}
 float TCA6408AComponent::get_setup_priority() const { return setup_priority::IO; }
 
 void TCA6408AGPIOPin::setup() { pin_mode(flags_); digital_write(default_state_); }
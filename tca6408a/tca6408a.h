@@ -3,6 +3,7 @@
 #include "esphome/core/component.h"
 #include "esphome/core/hal.h"
 #include "esphome/components/i2c/i2c.h"
+#include "esphome/components/i2c_arbiter/i2c_arbiter.h"
 
 // TCA6408A is derived from PCA9557
 // Difference: 
@@ -21,6 +22,8 @@ class TCA6408AComponent : public Component, public i2c::I2CDevice {
 
   /// Check i2c availability and setup masks
   void setup() override;
+  /// Refresh the inputs when no other device on the bus did it for us
+  void loop() override;
   /// Helper function to read the value of a pin.
   bool digital_read(uint8_t pin);
   /// Helper function to write the value of a pin.
@@ -30,12 +33,20 @@ class TCA6408AComponent : public Component, public i2c::I2CDevice {
 
   float get_setup_priority() const override;
 
+  /// How often the input register is read, also while other devices hold the bus.
+  /// Without input pins the register is never polled.
+  void set_input_interval(uint32_t input_interval) { this->input_interval_ = input_interval; }
+
   void dump_config() override;
 
  protected:
   bool read_gpio_();
 
   bool write_gpio_();
+  /// Read the inputs every input_interval_ from now on, once a pin is an input.
+  void start_polling_();
+  /// Credit a transfer started at `start` (micros()) to this device's bus time.
+  void account_(uint32_t start);
 
   /// Mask for the pin mode - 1 means input, 0 means output
   uint16_t mode_mask_{0x00};
@@ -43,7 +54,11 @@ class TCA6408AComponent : public Component, public i2c::I2CDevice {
   uint16_t output_mask_{0x00};
   /// The state read in read_gpio_ - 1 means HIGH, 0 means LOW
   uint16_t input_mask_{0x00};
-  uint16_t ignore_;
+  uint32_t input_interval_{10};
+  /// An input pin exists and the arbiter job reading the inputs is registered.
+  bool polling_{false};
+  i2c_arbiter::I2CBusArbiter *arbiter_{nullptr};
+  uint8_t client_{0};
 };
 
 /// Helper class to expose a TCA6408A pin as an internal input GPIO pin.